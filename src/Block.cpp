@@ -5,32 +5,27 @@
 #include "GridCell.hpp"
 #include "misc.hpp"
 
-int Block::m_xmax;
-int Block::m_ymax;
-int Block::m_ncell;
-Settings* Block::sim {};
-
-void Block::addPatch(int cellnum) {
-    m_patches.push_back(cellnum);
+void Block::addPatch(int index) {
+    m_patches.push_back(index);
     ++m_patchcount;
 }
-void Block::addCell(int cellnum) {
+void Block::addCell(const Settings& sim, int index) {
 
-    GridCell &cell { sim->Grid[cellnum] };
-    m_cells.push_back(cellnum);
+    int cellnum = sim.water.cell(index);
+    m_cells.push_back(index);
     ++m_cellcount;
     
     for (int season = 0; season <= 3; ++season) {
         // we don't need to multiply by maxU or divide by mean maxent value, because all values are treated equally in each season
-        m_total_food[season] += cell.maxent(season);
+        m_total_food[season] += sim.landscape.maxent(cellnum, season);
         //if (sm > m_max_food[season]) m_max_food[season] = sm;
     }
     
-    if (cell.Id <= m_ncell) {
-        float row = floor(cell.Id / m_xmax);
-        float col = cell.Id - row * m_xmax;
+    if (cellnum <= sim.ncell) {
+        float row = floor(cellnum / sim.xmx);
+        float col = cellnum - row * sim.xmx;
         float x = col + 0.5;
-        float y = m_ymax - (row + 0.5);
+        float y = sim.ymx - (row + 0.5);
         
         if (m_cellcount == 1) {
             m_block_xmin = x;
@@ -56,11 +51,11 @@ void Block::calcCenter() {
         m_center.y = m_block_ymin + (m_block_ymax - m_block_ymin) / 2;
     }
 }
-void Block::calcDensity() {
+void Block::calcDensity(const Settings& sim) {
     for (int season = 0; season <= 3; ++season) {
         m_density[season] = (m_total_food[season] / m_cellcount );
         // update 01.10.2022: change from using abundances, only use food value
-        m_value[season] = m_density[season] / GridCell::meanSeasonalMaxent[season];
+        m_value[season] = m_density[season] / sim.meanMaxent[season];
     }
 }
 void Block::calcValue() {
@@ -75,6 +70,7 @@ void Block::setN(int N) {
     m_N = N;
 }
 
+// index in Settings::water of a random cell in the block
 int Block::randomCell() const {
     if (m_cellcount > 0) {
         return (*select_randomly(m_cells.begin(), m_cells.end()));
@@ -11,12 +11,10 @@ class Settings;
 
 class Block {
 private:
-    static int m_xmax, m_ymax, m_ncell;
-    static Settings* sim;
     int m_id {}; // id = index in vector of blocks
     Vector2df m_center; // block center coordinates, calculated once all traversable cells are known
-    std::vector<int> m_cells; // traversable cells in block
-    std::vector<int> m_patches; // food patches in block
+    std::vector<int> m_cells; // traversable cells in block (indices in Settings::water)
+    std::vector<int> m_patches; // food patches in block (indices in Settings::water)
     int m_cellcount {}; // number of traversable cells in block
     int m_patchcount {}; // number of food patches in block
     float m_total_food[4] {}; // total food per season
@@ -31,11 +29,11 @@ public:
     //static float bestBlockValue[4];
     Block() = default;
     ~Block() = default;
-    int m_N { 1 }; // number of porpoises starting out in this block, used to calculate perceived block value
-    void addPatch(int cellnum);
-    void addCell(int cellnum);
+    int m_N { 1 }; // number of porpoises in this block, used to calculate perceived block value (see densityDependentBlocks)
+    void addPatch(int index);
+    void addCell(const Settings& sim, int index);
     void calcCenter();
-    void calcDensity();
+    void calcDensity(const Settings& sim);
     void calcValue();
     void setN(int N);
     int randomCell() const;
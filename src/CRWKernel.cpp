@@ -0,0 +1,76 @@
+#include <cmath>
+#include <Rcpp.h>
+#include "CRWKernel.hpp"
+#include "Porpoise.hpp"
+#include "Vector2d.hpp"
+#include "FastMath.hpp"
+
+void CRWBatch::add(Porpoise* porp) {
+    int l = m_n++;
+    m_porps[l] = porp;
+
+    // pres_mov still holds the previous step length here, as in the scalar model
+    float expectedEnergy = porp->calcExpectedEnergy();
+    m_contrib[l] = porp->sim->porpoise.inertia_const + porp->pres_mov * expectedEnergy; // emphasize CRW if food is plentiful
+
+    Vector2df foodAttraction = porp->calcFoodAttractionVector();
+    m_foodX[l] = foodAttraction.x;
+    m_foodY[l] = foodAttraction.y;
+
+    porp->drawCRW();
+    m_angle[l] = porp->pres_angle;
+    m_logmov[l] = porp->pres_logmov;
+    m_heading[l] = porp->Heading;
+    m_posX[l] = porp->currentPos.x;
+    m_posY[l] = porp->currentPos.y;
+}
+
+void CRWBatch::kernel() {
+    const int n = m_n;
+    const float deg2rad = PI / 180;
+    const float rad2deg = 180 / PI;
+
+    #pragma omp simd simdlen(width)
+    for (int l = 0; l < n; ++l) {
+        // pres_mov is measured in 100m steps
+        float mov = fastPow10(m_logmov[l]);
+
+        // slow down if turning sharply. Branches are written as selects, so 
+        // that all lanes can run the same instructions.
+        float absAngle = fabsf(m_angle[l]);
+        mov *= (mov > 10 && absAngle > 90) ? 0.2f : (mov > 7 && absAngle > 50) ? 0.5f : 1.0f;
+
+        float heading = m_heading[l] + m_angle[l];
+        heading = heading < 0 ? heading + 360 : heading > 360 ? heading - 360 : heading;
+
+        // CRW unit vector, scaled by expected foraging success, plus food attraction
+        float movX = fastSin(heading * deg2rad) * m_contrib[l] + m_foodX[l];
+        float movY = fastCos(heading * deg2rad) * m_contrib[l] + m_foodY[l];
+
+        // unit vector times pres_mov (and scaled from 100m to 400m grid)
+        float len = sqrtf(movX * movX + movY * movY);
+        float scale = (0.25f * mov) / (len < 0.000001f ? 0.000001f : len);
+        movX *= scale;
+        movY *= scale;
+
+        // turning angle of the new move, relative to current heading (subtract from 90 to get from x-axis to y-axis)
+        float turn = 90 - fastAtan2(movY, movX) * rad2deg - m_heading[l];
+        turn = turn < -180.0f ? turn + 360 : turn;
+        turn = turn > 180.0f ? turn - 360 : turn;
+
+        m_mov[l] = mov;
+        m_turn[l] = turn;
+        m_newX[l] = m_posX[l] + movX;
+        m_newY[l] = m_posY[l] + movY;
+    }
+}
+
+void CRWBatch::move() {
+    kernel();
+    for (int l = 0; l < m_n; ++l) {
+        Porpoise* porp = m_porps[l];
+        porp->pres_mov = m_mov[l];
+        porp->pres_angle = m_turn[l];
+        porp->finishIntrinsicMove(Vector2df(m_newX[l], m_newY[l]));
+    }
+}
@@ -0,0 +1,59 @@
+#ifndef __CRWKERNEL__
+#define __CRWKERNEL__
+
+class Porpoise;
+
+/*
+ * Batched correlated random walk for foraging porpoises. The state that a CRW
+ * move needs (heading, position, drawn turning angle and step length, CRW weight
+ * and food attraction) is gathered into one array per quantity for a group of
+ * porpoises, and the move itself - step length, slowdown, heading, mixing with
+ * the food attraction vector and the resulting turn - is computed for the whole
+ * group in a loop the compiler can vectorize. The group is as wide as a vector
+ * of floats on the target (16 lanes with AVX-512, 8 otherwise); without SIMD
+ * support the same loop simply runs lane by lane.
+ *
+ * The parts that can't be vectorized stay per porpoise: the random draws (the
+ * rejection loops in Porpoise::drawCRW), the memory terms, and finishing the move
+ * (avoiding shallow water and updating the porpoise's track and cell).
+ */
+class CRWBatch {
+public:
+#if defined(__AVX512F__)
+    static const int width = 16;
+#else
+    static const int width = 8;
+#endif
+
+private:
+    int m_n { 0 };
+    Porpoise* m_porps[width];
+
+    // input lanes
+    alignas(64) float m_heading[width];
+    alignas(64) float m_angle[width]; // turning angle drawn by the CRW
+    alignas(64) float m_logmov[width]; // log10 step length drawn by the CRW
+    alignas(64) float m_contrib[width]; // weight of the CRW relative to food attraction
+    alignas(64) float m_foodX[width], m_foodY[width]; // food attraction vector
+    alignas(64) float m_posX[width], m_posY[width];
+
+    // output lanes
+    alignas(64) float m_mov[width]; // step length, in 100m
+    alignas(64) float m_turn[width]; // turn relative to the current heading
+    alignas(64) float m_newX[width], m_newY[width];
+
+    void kernel();
+
+public:
+    int size() const { return m_n; }
+    bool full() const { return m_n == width; }
+    Porpoise* operator[](int lane) const { return m_porps[lane]; }
+
+    // gathers the state of a porpoise and draws its CRW turn and step length
+    void add(Porpoise* porp);
+    // moves every porpoise in the batch. The batch stays filled until clear().
+    void move();
+    void clear() { m_n = 0; }
+};
+
+#endif // __CRWKERNEL__
@@ -0,0 +1,76 @@
+#ifndef __CELLINDEX__
+#define __CELLINDEX__
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*
+ * Numbers a subset of the cells of the grid (the traversable cells) from 0 in
+ * cell order, so that per-cell records need only be kept for those. A bitmap
+ * of the grid, with the number of set bits before each 64-bit word, maps a
+ * cell number to its index in constant time (rank), and the list of cell
+ * numbers maps an index back to its cell (select).
+ */
+class CellIndex {
+public:
+    // starts an empty index over n cells
+    void reset(int n) {
+        m_ncell = n;
+        m_bits.assign((n + 63) / 64, 0);
+        m_ranks.assign(m_bits.size(), 0);
+        m_cells.clear();
+    }
+
+    // adds a cell, in increasing order of cell numbers, and returns its index
+    int add(int cell) {
+        m_bits[cell >> 6] |= uint64_t(1) << (cell & 63);
+        m_cells.push_back(cell);
+        return m_cells.size() - 1;
+    }
+
+    // builds the rank directory, once all cells are added
+    void finish() {
+        uint32_t count = 0;
+        for (size_t w = 0; w < m_bits.size(); ++w) {
+            m_ranks[w] = count;
+            count += popcount(m_bits[w]);
+        }
+        m_cells.shrink_to_fit();
+    }
+
+    int size() const { return m_cells.size(); }
+    int ncell() const { return m_ncell; }
+    const std::vector<int>& cells() const { return m_cells; }
+
+    bool contains(int cell) const {
+        return cell >= 0 && cell < m_ncell && ((m_bits[cell >> 6] >> (cell & 63)) & 1);
+    }
+    // index of a cell in the index
+    int rank(int cell) const {
+        uint64_t below = m_bits[cell >> 6] & ((uint64_t(1) << (cell & 63)) - 1);
+        return m_ranks[cell >> 6] + popcount(below);
+    }
+    // index of a cell, or -1 if it is not in the index
+    int indexOf(int cell) const { return contains(cell) ? rank(cell) : -1; }
+    // cell number of an index
+    int cell(int index) const { return m_cells[index]; }
+
+private:
+    int m_ncell { 0 };
+    std::vector<uint64_t> m_bits;
+    std::vector<uint32_t> m_ranks; // set bits in the words before each word
+    std::vector<int> m_cells;
+
+    static int popcount(uint64_t x) {
+#if defined(__GNUC__) || defined(__clang__)
+        return __builtin_popcountll(x);
+#else
+        x = x - ((x >> 1) & 0x5555555555555555ULL);
+        x = (x & 0x3333333333333333ULL) + ((x >> 2) & 0x3333333333333333ULL);
+        x = (x + (x >> 4)) & 0x0F0F0F0F0F0F0F0FULL;
+        return (x * 0x0101010101010101ULL) >> 56;
+#endif
+    }
+};
+
+#endif // __CELLINDEX__
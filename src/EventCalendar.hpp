@@ -0,0 +1,74 @@
+#ifndef __EVENTCALENDAR__
+#define __EVENTCALENDAR__
+#include <vector>
+#include <algorithm>
+
+class Porpoise;
+
+/*
+ * Day-indexed calendar of scheduled porpoise events (mating, giving birth,
+ * weaning, reaching the maximum age). There is one bucket per day of the year,
+ * and each entry holds the porpoise, the event and the day it is due, counted
+ * from the first day of the simulation's first year, so an event can be
+ * scheduled more than a year ahead. Each day, only the bucket of that day is
+ * visited, instead of checking every porpoise for something due.
+ *
+ * Entries point to porpoises, so a porpoise has to cancel its entries before it
+ * is deleted (see ~Porpoise).
+ */
+class EventCalendar {
+public:
+    enum Event { mating, birth, weaning, ageOut };
+    static const int daysPerYear = 365;
+
+    // number of the day yday (1-365) of the given simulation year
+    static int dayNumber(int year, int yday) { return (year - 1) * daysPerYear + yday; }
+
+private:
+    struct Entry {
+        Porpoise* porp;
+        int event;
+        int day;
+    };
+    std::vector<Entry> m_buckets[daysPerYear];
+    std::vector<Entry> m_due;
+
+    // bucket of a day number, or of a day of the year, since both give the same bucket
+    static int bucket(int day) { return (day - 1) % daysPerYear; }
+
+public:
+    void schedule(Porpoise* porp, int event, int day) {
+        m_buckets[bucket(day)].push_back({ porp, event, day });
+    }
+
+    // removes the porpoise's entries for event on the given day (day number or day of the year)
+    void cancel(const Porpoise* porp, int event, int day) {
+        if (day < 1) return;
+        auto& b = m_buckets[bucket(day)];
+        b.erase(std::remove_if(b.begin(), b.end(), [&](const Entry& e) {
+            return e.porp == porp && e.event == event;
+        }), b.end());
+    }
+
+    // calls f(porp, event) for every entry due on the given day, and removes it.
+    // Entries that f schedules for the same day are processed as well.
+    template<typename F>
+    void process(int day, F f) {
+        auto& b = m_buckets[bucket(day)];
+        while (true) {
+            auto due = std::stable_partition(b.begin(), b.end(), [&](const Entry& e) { return e.day > day; });
+            m_due.assign(due, b.end());
+            b.erase(due, b.end());
+            if (m_due.empty()) break;
+            for (const Entry& e : m_due) {
+                f(*e.porp, e.event);
+            }
+        }
+    }
+
+    void clear() {
+        for (auto& b : m_buckets) b.clear();
+    }
+};
+
+#endif // __EVENTCALENDAR__
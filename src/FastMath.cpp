@@ -0,0 +1,73 @@
+#include <Rcpp.h>
+#include <cmath>
+#include <string>
+#include "FastMath.hpp"
+#include "PorpoiseParameters.hpp"
+
+// Maximum absolute and relative deviation of an approximation from a reference,
+// over n evenly spaced points in [from, to]
+template<typename F, typename G>
+static void deviation(F approx, G exact, double from, double to, int n, double& maxAbs, double& maxRel) {
+    maxAbs = 0;
+    maxRel = 0;
+    for (int i = 0; i < n; ++i) {
+        float x = from + (to - from) * i / (n - 1);
+        double ref = exact(x);
+        double err = std::fabs(approx(x) - ref);
+        if (err > maxAbs) maxAbs = err;
+        if (ref != 0 && err / std::fabs(ref) > maxRel) maxRel = err / std::fabs(ref);
+    }
+}
+
+//' Check the fast math approximations against the C math library
+//' 
+//' Reports the maximum deviation of the approximated sin, cos, atan2, 10^x and
+//' log10 used in porpoise movement, and of the tabulated per-step survival 
+//' probability, from the values calculated with the C math library in double precision.
+//' 
+//' @param mMortProb,xSurvProb Survival parameters to tabulate the per-step survival for (see \code{\link{posim}}).
+//' @return A data frame with one row per function, giving the range checked and
+//' the maximum absolute and relative error.
+//' @export
+// [[Rcpp::export]]
+Rcpp::DataFrame validate_fastmath(double mMortProb = 1.0, double xSurvProb = 0.4) {
+    const int n = 1000001;
+    std::vector<std::string> fun;
+    std::vector<double> from, to, maxAbs, maxRel;
+    
+    auto check = [&](std::string name, double a, double b, double errAbs, double errRel) {
+        fun.push_back(name);
+        from.push_back(a);
+        to.push_back(b);
+        maxAbs.push_back(errAbs);
+        maxRel.push_back(errRel);
+    };
+    double errAbs, errRel;
+    
+    deviation([](float x) { return fastSin(x); }, [](double x) { return std::sin(x); }, -100, 100, n, errAbs, errRel);
+    check("sin", -100, 100, errAbs, errRel);
+    deviation([](float x) { return fastCos(x); }, [](double x) { return std::cos(x); }, -100, 100, n, errAbs, errRel);
+    check("cos", -100, 100, errAbs, errRel);
+    // atan2 around the unit circle, at the angle x
+    deviation([](float x) { return fastAtan2(std::sin(x), std::cos(x)); }, 
+              [](double x) { return std::atan2((float) std::sin(x), (float) std::cos(x)); }, -M_PI, M_PI, n, errAbs, errRel);
+    check("atan2", -M_PI, M_PI, errAbs, errRel);
+    deviation([](float x) { return fastPow10(x); }, [](double x) { return std::pow(10.0, x); }, -10, 10, n, errAbs, errRel);
+    check("pow10", -10, 10, errAbs, errRel);
+    deviation([](float x) { return fastLog10(x); }, [](double x) { return std::log10(x); }, 1e-3, 1e3, n, errAbs, errRel);
+    check("log10", 1e-3, 1e3, errAbs, errRel);
+    
+    // tabulated survival, for the given parameters
+    PorpoiseParameters params;
+    params.m_mort_prob = mMortProb;
+    params.x_surv_prob = xSurvProb;
+    params.updateSurvivalTable();
+    deviation([&](float e) { return params.stepSurvival(e); }, 
+              [=](double e) { return std::exp(std::log(1 - mMortProb * std::exp(-e * xSurvProb)) / 17520); }, 
+              0.01, 20, n, errAbs, errRel);
+    check("stepSurvival", 0.01, 20, errAbs, errRel);
+    
+    return Rcpp::DataFrame::create(Rcpp::Named("fun") = fun, Rcpp::Named("from") = from, Rcpp::Named("to") = to,
+                                   Rcpp::Named("maxAbsError") = maxAbs, Rcpp::Named("maxRelError") = maxRel,
+                                   Rcpp::Named("stringsAsFactors") = false);
+}
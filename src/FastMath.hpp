@@ -0,0 +1,134 @@
+#ifndef __FASTMATH__
+#define __FASTMATH__
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+/*
+ * Polynomial approximations of the transcendental functions in the porpoise
+ * step. They are branch-free (selects only) and inline, so they vectorize
+ * inside `omp simd` loops without relying on a vector math library. Accuracy,
+ * as reported by validate_fastmath():
+ *   fastSin, fastCos     abs. error < 1e-6 for |x| < 100 rad
+ *   fastAtan2            abs. error < 1e-6 rad
+ *   fastPow10            rel. error < 3e-6 for |x| < 10 (< 1e-6 for |x| < 2)
+ *   fastLog10            abs. error < 1e-6 for positive normal floats
+ */
+namespace fastmath {
+
+const float pi = 3.14159265358979f;
+const float halfPi = 1.57079632679490f;
+
+inline float asFloat(uint32_t i) { float f; std::memcpy(&f, &i, sizeof f); return f; }
+inline uint32_t asBits(float f) { uint32_t i; std::memcpy(&i, &f, sizeof i); return i; }
+
+// round to nearest integer, for arguments well within the range of int
+inline int roundToInt(float x) { return (int) (x + (x >= 0 ? 0.5f : -0.5f)); }
+
+} // namespace fastmath
+
+namespace fastmath {
+
+// reduces x to [-pi, pi], subtracting 2*pi in two parts to keep the precision
+inline float reduceAngle(float x) {
+    float k = (float) roundToInt(x * 0.159154943f);
+    return (x - k * 6.28125f) - k * 1.9353071795864769e-3f;
+}
+
+} // namespace fastmath
+
+// sine of x (radians): Taylor polynomial of degree 11 on [-pi/2, pi/2]
+inline float fastSin(float x) {
+    using namespace fastmath;
+    x = reduceAngle(x);
+    // reflect into [-pi/2, pi/2]
+    x = x > halfPi ? pi - x : x;
+    x = x < -halfPi ? -pi - x : x;
+    float x2 = x * x;
+    return x * (1.0f + x2 * (-1.6666667e-1f + x2 * (8.3333333e-3f + x2 * (-1.9841270e-4f
+             + x2 * (2.7557319e-6f + x2 * -2.5052108e-8f)))));
+}
+
+// cosine as a shifted sine, shifting after the reduction so that no precision is lost
+inline float fastCos(float x) {
+    return fastSin(fastmath::reduceAngle(x) + fastmath::halfPi);
+}
+
+// arctangent of y/x in (-pi, pi], from the polynomial in Abramowitz & Stegun
+// 4.4.49 for atan on [0, 1]
+inline float fastAtan2(float y, float x) {
+    using namespace fastmath;
+    float ax = x < 0 ? -x : x;
+    float ay = y < 0 ? -y : y;
+    float hi = ax > ay ? ax : ay;
+    float lo = ax > ay ? ay : ax;
+    float a = lo / (hi > 0 ? hi : 1.0f);
+    float a2 = a * a;
+    float r = a * (0.9999993329f + a2 * (-0.3332985605f + a2 * (0.1994653599f + a2 * (-0.1390853351f
+            + a2 * (0.0964200441f + a2 * (-0.0559098861f + a2 * (0.0218612288f + a2 * -0.0040540580f)))))));
+    r = ay > ax ? halfPi - r : r;
+    r = x < 0 ? pi - r : r;
+    return y < 0 ? -r : r;
+}
+
+// 2^y for -126 < y < 127: 2^floor(y) from the exponent bits, times a Taylor 
+// polynomial of degree 6 for 2^f around f = 0.5. Not clamped, since the compare
+// and select would keep the loops that use it from vectorizing.
+inline float fastExp2(float y) {
+    using namespace fastmath;
+    int i = (int) (y + 127.0f) - 127; // floor, truncating a positive number
+    float g = (y - i - 0.5f) * 0.693147181f; // (f - 0.5) * ln 2
+    float p = 1.41421356f * (1.0f + g * (1.0f + g * (0.5f + g * (1.6666667e-1f + g * (4.1666667e-2f
+            + g * (8.3333333e-3f + g * 1.3888889e-3f))))));
+    return p * asFloat((uint32_t) (i + 127) << 23);
+}
+
+// 10^x for |x| < 37
+inline float fastPow10(float x) {
+    return fastExp2(x * 3.32192809f); // log2(10)
+}
+
+// log10 of x > 0: exponent from the bits, plus the atanh series of the
+// mantissa reduced to [sqrt(1/2), sqrt(2))
+inline float fastLog10(float x) {
+    using namespace fastmath;
+    uint32_t bits = asBits(x);
+    int e = (int) ((bits >> 23) & 255) - 127;
+    float m = asFloat((bits & 0x007fffff) | 0x3f800000);
+    e = m > 1.41421356f ? e + 1 : e;
+    m = m > 1.41421356f ? m * 0.5f : m;
+    float s = (m - 1) / (m + 1);
+    float s2 = s * s;
+    float lnm = 2 * s * (1.0f + s2 * (3.3333333e-1f + s2 * (0.2f + s2 * (1.4285714e-1f + s2 * 1.1111111e-1f))));
+    return (e * 0.693147181f + lnm) * 0.434294482f; // ln to log10
+}
+
+/*
+ * Tabulated function on [min, max], evaluated by linear interpolation
+ */
+class LookupTable {
+private:
+    std::vector<float> m_values;
+    float m_min { 0 }, m_max { 0 }, m_scale { 0 };
+public:
+    template<typename F>
+    void build(float min, float max, int n, F f) {
+        m_min = min;
+        m_max = max;
+        m_scale = (n - 1) / (max - min);
+        m_values.resize(n);
+        for (int i = 0; i < n; ++i) {
+            m_values[i] = f(min + i / m_scale);
+        }
+    }
+    bool covers(float x) const { return x >= m_min && x < m_max; }
+    float operator()(float x) const {
+        float pos = (x - m_min) * m_scale;
+        int i = (int) pos;
+        i = i > (int) m_values.size() - 2 ? (int) m_values.size() - 2 : i; // rounding at the upper end
+        float f = pos - i;
+        return m_values[i] + f * (m_values[i + 1] - m_values[i]);
+    }
+};
+
+#endif // __FASTMATH__
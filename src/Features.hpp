@@ -0,0 +1,28 @@
+#ifndef __FEATURES__
+#define __FEATURES__
+
+class Settings;
+
+/*
+ * Optional parts of the porpoise step that are fixed for a whole run. The step
+ * kernels (execHalfhourTasks, execDailyTasks) are templates over these flags,
+ * and do_sim picks the instantiation matching the configuration once, before
+ * the time loop. A disabled feature is then compiled out of the per-porpoise
+ * loops, instead of being checked for every porpoise on every step.
+ */
+template<bool Fishery, bool Dispersal, bool Tracking>
+struct Features {
+    static const bool fishery = Fishery; // gillnets are set (fishery and effort data were given)
+    static const bool dispersal = Dispersal; // there is more than one block to disperse to
+    static const bool tracking = Tracking; // the logger follows some porpoises
+};
+
+// the step kernels of one instantiation
+struct StepKernels {
+    void (*halfhour)(Settings& sim);
+    void (*daily)(Settings& sim);
+};
+
+StepKernels selectStepKernels(bool fishery, bool dispersal, bool tracking);
+
+#endif // __FEATURES__
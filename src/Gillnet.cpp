@@ -7,19 +7,14 @@
 
 // todo: handle tries >= 10 in posOK routine better
 
-std::vector<float> Gillnet::interaction_probability;
-float Gillnet::m_catchability_by_type[3];
-
-Settings* Gillnet::sim;
-
-Gillnet::Gillnet(int block, int type, int soaktime, float length, bool pingered) {
+Gillnet::Gillnet(Settings* sim, int block, int type, int soaktime, float length, bool pingered) : sim(sim) {
     m_block = block;
     m_type = type;
     m_max_soaktime = soaktime;
     m_length = length;
     m_pingered = pingered;
     
-    m_catchability = m_catchability_by_type[type];
+    m_catchability = sim->catchability_by_type[type];
     if (pingered == true) {
         m_catchability *= sim->pinger_effect;
     }
@@ -44,7 +39,7 @@ Gillnet::Gillnet(int block, int type, int soaktime, float length, bool pingered)
         start.y += getRandomFloat(-0.49, 0.49); // offset y from center by random distance
         // calculate xy coordinates for the end of our segment
         end = Vector2df(start.x + m_length * cos(theta), start.y + m_length * sin(theta));
-        //Logger::debug(0, "gillnet: theta = %f, m_length = %f, x1 = %f, y1 = %f", theta, m_length, end.x, end.y);
+        //sim->debug(0, "gillnet: theta = %f, m_length = %f, x1 = %f, y1 = %f", theta, m_length, end.x, end.y);
         
         // list of cells intersected by gillnet
         m_cellnums = sim->GetCellsIntersected(start.x, start.y, end.x, end.y);
@@ -57,7 +52,7 @@ Gillnet::Gillnet(int block, int type, int soaktime, float length, bool pingered)
             // then check the depth of each cell, and if we find at least one that is not deep
             // enough, generate a new position for the gillnet
             for (const auto& cell : m_cellnums) {
-                if (cell == -1 || sim->Grid[cell].Bathymetry > sim->MinimumWaterDepth) {
+                if (cell == -1 || sim->landscape.bathymetry(cell) > sim->MinimumWaterDepth) {
                     posOK = false;
                 }
                 break;
@@ -70,15 +65,19 @@ Gillnet::Gillnet(int block, int type, int soaktime, float length, bool pingered)
     m_coords.second = end;
     sort(m_cellnums.begin(), m_cellnums.end());
     
+    // porpoises are only ever in traversable cells, so only those need to know of the gillnet
     for (const auto& cell : m_cellnums) {
-        sim->Grid[cell].gillnets.push_front(this);
-        m_cells.push_back(sim->Grid[cell].gillnets.begin());
+        int index = sim->water.indexOf(cell);
+        if (index == -1) continue;
+        sim->Grid[index].gillnets.push_front(this);
+        m_cells.push_back(sim->Grid[index].gillnets.begin());
+        m_gridCells.push_back(index);
     }
 }
 
 Gillnet::~Gillnet() {
-    for (int i = 0; i < m_cellnums.size(); ++i) {
-        sim->Grid[i].gillnets.erase(m_cells[i]);
+    for (int i = 0; i < m_cells.size(); ++i) {
+        sim->Grid[m_gridCells[i]].gillnets.erase(m_cells[i]);
     }
 }
 
@@ -98,7 +97,7 @@ bool Gillnet::check4(Vector2df xy, int cell) {
     // then proceed to do further checks
     dist = sqrt(dist); // calculate distance
     int index = round(dist * 800) * 0.5; // find index in lookup table of probabilities
-    float prob_interaction = interaction_probability[index];
+    float prob_interaction = sim->interaction_probability[index];
     float prob_entangled = prob_interaction * m_catchability;
     
     // finally check if porp was entangled
@@ -128,7 +127,7 @@ bool Gillnet::check3(Vector2df xy, int cell) {
         // Proceed to do further checks
         dist = sqrt(dist); // calculate distance
         int index = round(dist * 800); // find index in lookup table of probabilities
-        const float& prob_interaction = interaction_probability[index];
+        const float& prob_interaction = sim->interaction_probability[index];
         float prob_entangled = prob_interaction * m_catchability;
         
         // finally check if porp was entangled
@@ -152,7 +151,7 @@ bool Gillnet::check2(std::pair<Vector2df, Vector2df> path) {
     //float maxp { 0.0531923f };
     //float prob_interaction = R::dnorm4(dist, 0.0, 7.5, false) / maxp;
     
-    float prob_interaction = interaction_probability[index];
+    float prob_interaction = sim->interaction_probability[index];
     float prob_entangled = prob_interaction * m_catchability;
      */
     
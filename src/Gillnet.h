@@ -10,13 +10,12 @@
 class Settings;
 
 class Gillnet {
-    static Settings* sim;
-    static float m_catchability_by_type[3];
+    Settings* sim; // the simulation the gillnet is set in
     friend class Settings;
     std::vector<int> m_cellnums; // which cells are covered by this line segment?
-    std::vector<std::list<Gillnet*>::iterator> m_cells;
+    std::vector<std::list<Gillnet*>::iterator> m_cells; // this gillnet in the lists of the traversable cells covered
+    std::vector<int> m_gridCells; // indices in Grid of those cells
     std::pair<Vector2df, Vector2df> m_coords;
-    static std::vector<float> interaction_probability;
     float m_length { 0.0f }; // total length of gillnet string in units of 400m
     int m_block;
     int m_type; // gillnet mesh size, 0 = small, 1 = medium, 2 = large
@@ -26,7 +25,7 @@ class Gillnet {
     float m_catchability; // harbour porpoise catchability
     bool m_pingered { false }; // does the gillnet have pingers?
 public:
-    Gillnet(int block, int type, int soaktime, float length, bool pingered);
+    Gillnet(Settings* sim, int block, int type, int soaktime, float length, bool pingered);
     ~Gillnet();
     std::pair<Vector2df, Vector2df> get() { return m_coords; }
     int soaktime() { return m_soaktime; }
@@ -41,6 +40,7 @@ public:
     bool check4(Vector2df xy, int cell);
     int type() { return m_type; }
     float length() { return m_length; }
+    const std::vector<int>& cells() const { return m_cellnums; }
 };
 
 #endif // __GILLNET__
@@ -1,25 +1,17 @@
 #include "GridCell.hpp"
+#include "Settings.hpp"
 
-float GridCell::foodGrowthRate = 0.2; // overwritten in sim constructor
-int GridCell::season = 0; // overwritten in sim constructor
-float GridCell::meanSeasonalMaxent[4]; // set in sim::initData()
-
-GridCell::GridCell(int id, int block, int abundanceRegion, int fisheryBlock, float bathy, float distToCoast, float distToEdge, float food, float maxent1, float maxent2, float maxent3, float maxent4) : 
-    Id(id), Block(block), abundanceBlock(abundanceRegion), fisheryBlock(fisheryBlock), Bathymetry(bathy), DistanceToCoast(distToCoast), DistanceToEdge(distToEdge), MaximumUtility(food) {
-    
-    maxentLevel[0] = maxent1;
-    maxentLevel[1] = maxent2;
-    maxentLevel[2] = maxent3;
-    maxentLevel[3] = maxent4;
-    
-    if (MaximumUtility > 0) {
-        updateMax();
+void GridCell::reset(const Settings& sim) {
+    gillnets.clear();
+    float maximumUtility = sim.landscape.maximumUtility(Id);
+    if (maximumUtility > 0) {
+        updateMax(sim);
         // initialize with extra food to compensate for porpoises starting out with a blank memory
-        CurrentUtility = MaximumUtility * 1 / meanSeasonalMaxent[season];
+        CurrentUtility = maximumUtility * 1 / sim.meanMaxent[sim.season];
     }
 }
 
-void GridCell::Regenerate() {
+void GridCell::Regenerate(float foodGrowthRate) {
     if (CurrentUtility < currentMax) {
         //CurrentUtility += foodGrowthRate * CurrentUtility * (1 - CurrentUtility / (currentMax / meanSeasonalMaxent[season]));
         
@@ -35,14 +27,6 @@ void GridCell::Regenerate() {
     }
 }
 
-void GridCell::setSeason(int newSeason) {
-    season = newSeason;
-}
-
-void GridCell::updateMax() {
-    currentMax = MaximumUtility * maxentLevel[season] / meanSeasonalMaxent[season];
-}
-
-float GridCell::maxent(int season) const {
-    return maxentLevel[season];
+void GridCell::updateMax(const Settings& sim) {
+    currentMax = sim.landscape.maximumUtility(Id) * sim.landscape.maxent(Id, sim.season) / sim.meanMaxent[sim.season];
 }
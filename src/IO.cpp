@@ -2,83 +2,64 @@
 #include <iostream>
 #include <fstream>
 #include <string>
-#include <sstream>
 #include <algorithm>
 
 #include "GridCell.hpp"
 #include "Block.hpp"
 #include "IO.hpp"
 #include "Vector2d.hpp"
+#include "LandscapeFile.hpp"
+#include "TextFile.hpp"
 
 class GridCell;
 
+// Reads the landscape from a sasc file or a binary landscape file (see LandscapeFile),
+// and sets up the grid cells, blocks and regions
 void read_gis(const std::string filename, Settings* sim) {
-
-    std::fstream fid (filename, std::ios::in);
-    std::string line;
-    bool header = false;
-    int cellnum = 0;
-
-    if(!fid.is_open()) {
-        // throw error in R and stop further execution
-        Rcpp::stop("read_gis: Could not open file for reading.");
-        return;
+    
+    LandscapeFile file;
+    file.read(filename);
+    
+    const LandscapeHeader& h = file.header;
+    if (file.ncell != (int64_t) h.xmx * h.ymx) {
+        // cells are numbered, and the per-cell indexes sized, from the header
+        Rcpp::stop("%s has %d cells, header says %d x %d", filename, (int) file.ncell, h.xmx, h.ymx);
     }
+    sim->initData(h.xmx, h.ymx, h.nsurv, h.nfish, h.nblock, h.ntrav, h.bsize, h.npatch, h.meanMaxent[0], h.meanMaxent[1], h.meanMaxent[2], h.meanMaxent[3]);
     
-    while(getline(fid, line)) {
-        std::stringstream str(line);
-        std::string column;
-        std::vector<std::string> data;
-        
-        if (line.empty()) {
-            break;
-        }
-        
-        while (std::getline(str, column, ';')) { 
-            if (column != "") data.push_back(column); 
-        }
-        
-        if (header == false) {
-            if (data.size() != 12) {
-                Rcpp::stop("Bad header in %s: wanted 12 columns, got %d", filename, data.size());
-                return;
-            }
-            int xmx = stoi(data[0]);
-            int ymx = stoi(data[1]);
-            int nsurv = stoi(data[2]);
-            int nfish = stoi(data[3]);
-            int nblock = stoi(data[4]);
-            int ntrav = stoi(data[5]);
-            int bsize = stoi(data[6]);
-            int npatch = stoi(data[7]);
-            float meanMaxent1 = stof(data[8]);
-            float meanMaxent2 = stof(data[9]);
-            float meanMaxent3 = stof(data[10]);
-            float meanMaxent4 = stof(data[11]);
-            sim->initData(xmx, ymx, nsurv, nfish, nblock, ntrav, bsize, npatch, meanMaxent1, meanMaxent2, meanMaxent3, meanMaxent4),
-            header = true;
-            continue;
-        }
-
-        if (data.size() != 10) {
-            Rcpp::stop("Bad data on line %d: wanted 10 columns, got %d", cellnum, data.size());
-            return;
-        }
+    const float* bathymetry = file.floats(LandscapeFile::bathymetry);
+    const float* distanceToCoast = file.floats(LandscapeFile::distToCoast);
+    const int32_t* abundanceRegions = file.ints(LandscapeFile::abundanceRegion);
+    const int32_t* fisheryRegions = file.ints(LandscapeFile::fisheryRegion);
+    const int32_t* blocks = file.ints(LandscapeFile::block);
+    const float* food = file.floats(LandscapeFile::foodLevel);
+    const float* maxent[4] = { file.floats(LandscapeFile::maxent1), file.floats(LandscapeFile::maxent2),
+                               file.floats(LandscapeFile::maxent3), file.floats(LandscapeFile::maxent4) };
+    
+    Landscape& cells = sim->landscape;
+    cells.resize(file.ncell);
+    float* cellBathymetry = cells.floats(Landscape::Bathymetry);
+    float* cellDistToCoast = cells.floats(Landscape::DistToCoast);
+    float* cellDistToEdge = cells.floats(Landscape::DistToEdge);
+    float* cellFood = cells.floats(Landscape::MaximumUtility);
+    int32_t* cellBlock = cells.ints(Landscape::FoodBlock);
+    int32_t* cellAbundanceRegion = cells.ints(Landscape::AbundanceRegion);
+    int32_t* cellFisheryRegion = cells.ints(Landscape::FisheryRegion);
+    float* cellMaxent[4] = { cells.floats(Landscape::Maxent1), cells.floats(Landscape::Maxent2),
+                             cells.floats(Landscape::Maxent3), cells.floats(Landscape::Maxent4) };
+    
+    for (int cellnum = 0; cellnum < file.ncell; ++cellnum) {
         
-        float averageDepth = stof(data[0]);
-        float distToCoast = stof(data[1]);
-        int abundanceRegion = stoi(data[2]) - 1;
+        float averageDepth = bathymetry[cellnum];
+        float distToCoast = distanceToCoast[cellnum];
+        int abundanceRegion = abundanceRegions[cellnum] - 1;
         
         if (abundanceRegion < 0 || abundanceRegion >= sim->nSurveyBlocks) {
             abundanceRegion = -1;
         }
-        int fisheryRegion = stoi(data[3]) - 1;
-        int foodBlock = stoi(data[4]) -1;
-        float foodLevel = stof(data[5]);
-        float maxent1 =  stof(data[6]);
-        float maxent2 =  stof(data[7]);
-        float maxent3 =  stof(data[8]);
-        float maxent4 =  stof(data[9]);
+        int fisheryRegion = fisheryRegions[cellnum] - 1;
+        int foodBlock = blocks[cellnum] - 1;
+        float foodLevel = food[cellnum];
         
         bool cellTraversable = averageDepth <= sim->MinimumWaterDepth;
         bool containsFood = cellTraversable && foodLevel > 0.0f;
@@ -94,27 +75,30 @@ void read_gis(const std::string filename, Settings* sim) {
                                     sim->xmx - cellCoords.x + 0.5, 
                                     sim->ymx - cellCoords.y + 0.5 });
 
-        sim->Grid.emplace_back(cellnum, 
-                               foodBlock, 
-                               -1, //abundanceRegion, 
-                               fisheryRegion, 
-                               averageDepth, 
-                               distToCoast, 
-                               distToEdge, 
-                               foodLevel, 
-                               maxent1, maxent2, maxent3, maxent4);
+        cellBathymetry[cellnum] = averageDepth;
+        cellDistToCoast[cellnum] = distToCoast;
+        cellDistToEdge[cellnum] = distToEdge;
+        cellFood[cellnum] = foodLevel;
+        cellBlock[cellnum] = foodBlock;
+        cellAbundanceRegion[cellnum] = -1; // set in postProcessData
+        cellFisheryRegion[cellnum] = fisheryRegion;
+        for (int season = 0; season < 4; ++season) {
+            cellMaxent[season][cellnum] = maxent[season][cellnum];
+        }
 
+        // only traversable cells get a grid cell, and are referred to by their index among these
         if (cellTraversable) {
-            sim->TraversableCells.push_back(cellnum);
-            sim->Blocks[foodBlock].addCell(cellnum);
+            int index = sim->water.add(cellnum);
+            sim->Grid.emplace_back(cellnum);
+            sim->Blocks[foodBlock].addCell(*sim, index);
             
             if (containsFood) {
-                sim->Patches.push_back(cellnum);
-                sim->Blocks[foodBlock].addPatch(cellnum);
+                sim->Patches.push_back(index);
+                sim->Blocks[foodBlock].addPatch(index);
             }
             
             if (abundanceRegion != -1) {
-                sim->abundanceRegions[abundanceRegion].addCell(cellnum);
+                sim->abundanceRegions[abundanceRegion].addCell(index);
             }
             
             if (distToCoast > 2.5f && averageDepth >= -400 && fisheryRegion >= 0 && fisheryRegion < sim->nFisheryBlocks) {
@@ -122,9 +106,28 @@ void read_gis(const std::string filename, Settings* sim) {
             }
             
         }
-        ++cellnum;
     }
-    fid.close();
+    sim->water.finish();
+}
+
+// one row of the fishery data file
+struct HaulRow {
+    int32_t block, year, day, type, N, pinger;
+};
+
+// one row of the fishing effort file
+struct EffortRow {
+    int32_t block, season, type, soaktime;
+    float length;
+};
+
+// stops with the line and kind of the first bad line found by TextFile::parse
+static void stopOnError(const TextFile::Error& error, const std::string& filename, const char* caller, int nField) {
+    if (error.badCount) {
+        Rcpp::stop("%s: bad data on line %d of %s: wanted %d columns, got %d", caller, (int) error.line, filename, nField, error.nField);
+    } else if (error.line != -1) {
+        Rcpp::stop("%s: bad data on line %d of %s: not a number", caller, (int) error.line, filename);
+    }
 }
 
 int read_fishery_data(const std::string filename, Fishery& fishery) {
@@ -135,49 +138,36 @@ int read_fishery_data(const std::string filename, Fishery& fishery) {
     int nDay = 365;
     int nType = fishery.nType();
     int nSample = fishery.nSample();
-    std::fstream fid (filename, std::ios::in);
-    std::string line;
+    TextFile text;
     
-    if(!fid.is_open()) {
+    if(!text.open(filename)) {
         // throw error in R and stop further execution
         Rcpp::stop("read_fishery_data: Could not open file for reading.");
     }
     
-    getline(fid, line); // read and discard first line (skip header)
+    // parse rows in parallel, skipping the header
+    std::vector<HaulRow> rows(text.nRow());
+    TextFile::Error error = text.parse(6, TextFile::maxField, [&rows](int64_t i, const TextFile::Fields& fields) {
+        HaulRow& row = rows[i];
+        return fields.getInt(0, row.block) && fields.getInt(1, row.year) && fields.getInt(2, row.day) 
+            && fields.getInt(3, row.type) && fields.getInt(4, row.N) && fields.getInt(5, row.pinger);
+    });
+    stopOnError(error, filename, "read_fishery_data", 6);
     
-    while(getline(fid, line)) {
-        std::stringstream str(line);
-        std::string column;
-        std::vector<std::string> data;
-        
-        if (line.empty()) break;
-        
-        
-        while (std::getline(str, column, ';')) { 
-            data.push_back(column); 
-        }
-        
-        int block = stoi(data[0]);
-        int year = stoi(data[1]);
-        int day = stoi(data[2]);
-        int type = stoi(data[3]);
-        int N = stoi(data[4]);
-        bool pinger = stoi(data[5]);
-
-        if (block >= 0 && block < nBlock 
-                && day >= 0 && day < nDay 
-                && type >= 0 && type < nType 
-                && year >= 0 && year < nSample 
-                && N > 0) 
+    // and add them in file order
+    for (const auto& row : rows) {
+        if (row.block >= 0 && row.block < nBlock 
+                && row.day >= 0 && row.day < nDay 
+                && row.type >= 0 && row.type < nType 
+                && row.year >= 0 && row.year < nSample 
+                && row.N > 0) 
         {
-            fishery.addHauls(block, day, type, year, N, pinger);
+            fishery.addHauls(row.block, row.day, row.type, row.year, row.N, row.pinger);
             ++sample_size;
-        } else if (N > 0) {
+        } else if (row.N > 0) {
             ++bad_data_count;
         }
     }
-    
-    fid.close();
 
     if (bad_data_count > 0) {
         Rcpp::warning("%d rows contained out of range data, please verify data and settings", bad_data_count);
@@ -190,45 +180,34 @@ int read_fishing_effort(const std::string filename, Fishery& fishery) {
     int nSeason = 4;
     int nType = fishery.nType();
     int sample_size = 0;
+    TextFile text;
     
-    std::fstream fid (filename, std::ios::in);
-    std::string line;
-    
-    if(!fid.is_open()) {
+    if(!text.open(filename)) {
         // throw error in R and stop further execution
         Rcpp::stop("read_fishing_effort: Could not open file for reading.");
     }
     
-    getline(fid, line); // read and discard first line (skip header)
+    // parse rows in parallel, skipping the header
+    std::vector<EffortRow> rows(text.nRow());
+    TextFile::Error error = text.parse(5, TextFile::maxField, [&rows](int64_t i, const TextFile::Fields& fields) {
+        EffortRow& row = rows[i];
+        return fields.getInt(0, row.block) && fields.getInt(1, row.season) && fields.getInt(2, row.type) 
+            && fields.getInt(3, row.soaktime) && fields.getFloat(4, row.length);
+    });
+    stopOnError(error, filename, "read_fishing_effort", 5);
     
-    while(getline(fid, line)) {
-        std::stringstream str(line);
-        std::string column;
-        std::vector<std::string> data;
-        
-        if (line.empty()) break;
-        
-        while (std::getline(str, column, ';')) { 
-            data.push_back(column); 
-        }
-        
-        int block = stoi(data[0]);
-        int season = stoi(data[1]);
-        int type = stoi(data[2]);
-        int soaktime = stoi(data[3]);
-        float length = stof(data[4]);
-        
-        if (block >= 0 && block < nBlock 
-                && season >= 0 && season < nSeason 
-                && type >= 0 && type < nType
-                && soaktime >= 0
-                && length > 0.0f) 
+    // and add them in file order, as effort is sampled from them in that order
+    for (const auto& row : rows) {
+        if (row.block >= 0 && row.block < nBlock 
+                && row.season >= 0 && row.season < nSeason 
+                && row.type >= 0 && row.type < nType
+                && row.soaktime >= 0
+                && row.length > 0.0f) 
         {
-            fishery.addEffort(block, season, type, soaktime, length);
+            fishery.addEffort(row.block, row.season, row.type, row.soaktime, row.length);
             ++sample_size;
         }
     }
     
-    fid.close();
     return sample_size;
 }
@@ -0,0 +1,111 @@
+#ifndef __LANDSCAPE__
+#define __LANDSCAPE__
+#include <cstdint>
+#include <memory>
+#include <vector>
+#include "MappedFile.hpp"
+#include "TileCache.hpp"
+
+/*
+ * The cell data that does not change during a simulation, one array per field,
+ * indexed by cell number. Mutable cell state (food levels, gillnets) is kept
+ * in GridCell.
+ *
+ * While the landscape is read and preprocessed the arrays are owned. They can
+ * then be replaced by arrays in a mapped file (see Settings::loadLandscapeCache),
+ * which are shared with every other process mapping the same file, instead of
+ * each process holding its own copy, or by a TileCache, which holds only the
+ * parts of the landscape in use.
+ *
+ * Copies share the arrays, owned or mapped, so the simulations run on one
+ * loaded landscape hold a single copy of the cell data between them. Tiles are
+ * cached per thread, so a copy reads the same tile file through caches of its own.
+ */
+class Landscape {
+public:
+    enum Column { Bathymetry, DistToCoast, DistToEdge, MaximumUtility, Maxent1, Maxent2, Maxent3, Maxent4,
+                  FoodBlock, AbundanceRegion, FisheryRegion };
+    static const int nColumn = 11;
+    static bool isIntColumn(int column) { return column >= FoodBlock; }
+
+    Landscape() = default;
+    Landscape(const Landscape& other) { *this = other; }
+    Landscape& operator=(const Landscape& other) {
+        if (this == &other) return *this;
+        m_ncell = other.m_ncell;
+        m_owned = other.m_owned;
+        m_mapping = other.m_mapping;
+        m_tiles.reset(other.m_tiles ? new TileCache(*other.m_tiles) : nullptr);
+        for (int c = 0; c < nColumn; ++c) m_columns[c] = other.m_columns[c];
+        return *this;
+    }
+
+    // allocates owned arrays for n cells, zero-filled
+    void resize(int64_t n) {
+        m_ncell = n;
+        m_mapping.reset();
+        m_tiles.reset();
+        m_owned = std::make_shared<Owned>();
+        for (int c = 0; c < nColumn; ++c) {
+            m_owned->columns[c].assign(n, 0);
+            m_columns[c] = m_owned->columns[c].data();
+        }
+    }
+
+    // uses arrays of n cells in a mapped file, which is kept open as long as they are used
+    void attach(std::unique_ptr<MappedFile> mapping, const void* const* columns, int64_t n) {
+        m_ncell = n;
+        m_mapping = std::move(mapping);
+        m_tiles.reset();
+        m_owned.reset();
+        for (int c = 0; c < nColumn; ++c) {
+            m_columns[c] = columns[c];
+        }
+    }
+
+    // reads cells from tiles, dropping the arrays
+    void useTiles(std::unique_ptr<TileCache> tiles) {
+        m_mapping.reset();
+        m_owned.reset();
+        for (int c = 0; c < nColumn; ++c) {
+            m_columns[c] = nullptr;
+        }
+        m_tiles = std::move(tiles);
+    }
+
+    int64_t ncell() const { return m_ncell; }
+    bool shared() const { return m_mapping != nullptr; }
+    TileCache* tiles() const { return m_tiles.get(); } // nullptr if the arrays are in memory
+    const void* column(int c) const { return m_columns[c]; } // nullptr if tiled
+
+    // writable arrays, only while the arrays are owned (and before the landscape is copied)
+    float* floats(Column c) { return reinterpret_cast<float*>(m_owned->columns[c].data()); }
+    int32_t* ints(Column c) { return reinterpret_cast<int32_t*>(m_owned->columns[c].data()); }
+
+    float bathymetry(int cell) const { return get<float>(Bathymetry, cell); } // average water depth in cell
+    float distToCoast(int cell) const { return get<float>(DistToCoast, cell); } // in units of number of cells
+    float distToEdge(int cell) const { return get<float>(DistToEdge, cell); } // distance to nearest edge of landscape
+    float maximumUtility(int cell) const { return get<float>(MaximumUtility, cell); } // max food level, not adjusted for seasonal maxent
+    float maxent(int cell, int season) const { return get<float>(Maxent1 + season, cell); } // maxent level per quarter
+    int block(int cell) const { return get<int32_t>(FoodBlock, cell); }
+    int abundanceRegion(int cell) const { return get<int32_t>(AbundanceRegion, cell); }
+    int fisheryRegion(int cell) const { return get<int32_t>(FisheryRegion, cell); }
+
+private:
+    struct Owned {
+        std::vector<uint32_t> columns[nColumn];
+    };
+
+    int64_t m_ncell { 0 };
+    std::shared_ptr<Owned> m_owned;
+    const void* m_columns[nColumn] {};
+    std::shared_ptr<MappedFile> m_mapping;
+    std::unique_ptr<TileCache> m_tiles;
+
+    template<class T> T get(int c, int cell) const {
+        if (m_tiles) return m_tiles->get<T>(c, cell);
+        return static_cast<const T*>(m_columns[c])[cell];
+    }
+};
+
+#endif // __LANDSCAPE__
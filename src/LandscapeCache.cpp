@@ -0,0 +1,347 @@
+#include <Rcpp.h>
+#include <cstring>
+#include <cstdio>
+#include <chrono>
+#include <memory>
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "Settings.hpp"
+#include "GridCell.hpp"
+#include "Block.hpp"
+#include "abundanceRegion.hpp"
+#include "MappedFile.hpp"
+#include "LandscapeCache.hpp"
+
+/*
+ * Cache of the preprocessed landscape, i.e. the state of Settings after read_gis
+ * and postProcessData: the cell data, traversable cells, food patches, blocks,
+ * abundance regions and fishery regions. Cache files are named after a hash
+ * of the landscape file and of the parameters used in preprocessing, so a
+ * cache file is only ever read for the landscape and parameters it was written
+ * from, and changed landscape files get a new cache file.
+ *
+ * The file holds a fixed header (magic "POSIMLCC", format version, byte order
+ * mark and the key), followed by the data, each vector prefixed by its length.
+ * The cell arrays of Landscape are aligned to 64 bytes, so that they can be used
+ * in place from the mapped file (shareLandscape in R).
+ */
+
+static const char magic[8] = { 'P', 'O', 'S', 'I', 'M', 'L', 'C', 'C' };
+static const uint32_t version = 3; // increase when the layout below, or preprocessing, changes
+static const size_t alignment = 64;
+static const uint32_t byteOrderMark = 0x01020304;
+
+struct CacheHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t key;
+};
+
+struct BlockRecord {
+    int32_t id;
+    float center[2];
+    float totalFood[4], density[4], value[4];
+    float xmin, xmax, ymin, ymax;
+};
+
+static const uint64_t fnvOffset = 14695981039346656037ULL;
+static const uint64_t fnvPrime = 1099511628211ULL;
+
+// FNV-1a, over 8-byte words
+static uint64_t fnv1a(const char* data, size_t n, uint64_t h = fnvOffset) {
+    size_t i = 0;
+    for (; i + 8 <= n; i += 8) {
+        uint64_t word;
+        std::memcpy(&word, data + i, sizeof word);
+        h = (h ^ word) * fnvPrime;
+    }
+    for (; i < n; ++i) {
+        h = (h ^ (unsigned char) data[i]) * fnvPrime;
+    }
+    return h;
+}
+
+template<class T>
+static uint64_t hashValue(const T& value, uint64_t h) {
+    return fnv1a(reinterpret_cast<const char*>(&value), sizeof value, h);
+}
+
+uint64_t landscapeCacheKey(const std::string& sasc, float minimumWaterDepth, float maxU) {
+    MappedFile file;
+    if (!file.open(sasc)) return 0;
+    uint64_t key = fnv1a(file.data(), file.size());
+    key = hashValue(version, key);
+    key = hashValue(minimumWaterDepth, key);
+    return hashValue(maxU, key);
+}
+
+std::string landscapeCacheFile(const std::string& dir, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.posimcache", (unsigned long long) key);
+    return dir + "/" + name;
+}
+
+std::string landscapeTileFile(const std::string& dir, uint64_t key) {
+    char name[32];
+    std::snprintf(name, sizeof name, "%016llx.posimtiles", (unsigned long long) key);
+    return dir + "/" + name;
+}
+
+// writes values and vectors of trivially copyable types
+class CacheWriter {
+    std::ofstream& m_out;
+    size_t m_pos { 0 };
+public:
+    explicit CacheWriter(std::ofstream& out) : m_out(out) {}
+    void write(const void* data, size_t n) {
+        m_out.write(static_cast<const char*>(data), n);
+        m_pos += n;
+    }
+    template<class T> void put(const T& value) {
+        write(&value, sizeof value);
+    }
+    template<class T> void put(const std::vector<T>& values) {
+        put<uint64_t>(values.size());
+        write(values.data(), values.size() * sizeof(T));
+    }
+    // pads the file up to the next multiple of alignment
+    void align() {
+        static const char padding[alignment] {};
+        write(padding, (alignment - m_pos % alignment) % alignment);
+    }
+};
+
+// reads what CacheWriter wrote; reads fail, rather than run past the end of the file
+class CacheReader {
+    const char* m_p;
+    const char* m_end;
+public:
+    CacheReader(const char* data, size_t size) : m_p(data), m_end(data + size) {}
+    template<class T> bool get(T& value) {
+        if ((size_t) (m_end - m_p) < sizeof value) return false;
+        std::memcpy(&value, m_p, sizeof value);
+        m_p += sizeof value;
+        return true;
+    }
+    template<class T> bool get(std::vector<T>& values) {
+        uint64_t n;
+        if (!get(n) || n > (uint64_t) (m_end - m_p) / sizeof(T)) return false;
+        values.resize(n);
+        std::memcpy(values.data(), m_p, n * sizeof(T));
+        m_p += n * sizeof(T);
+        return true;
+    }
+    // an array of n bytes in place, or nullptr past the end of the file
+    const void* take(size_t n) {
+        if ((size_t) (m_end - m_p) < n) return nullptr;
+        const void* data = m_p;
+        m_p += n;
+        return data;
+    }
+    void align(const char* base) {
+        size_t pos = m_p - base;
+        m_p += std::min<size_t>((alignment - pos % alignment) % alignment, m_end - m_p);
+    }
+    bool atEnd() const { return m_p == m_end; }
+};
+
+void Settings::saveLandscapeCache(const std::string& filename, uint64_t key) const {
+    // write to a file of our own, and then move it into place, so that runs started
+    // at the same time never read a partly written cache file
+    std::string tmp = filename + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::ofstream out(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) {
+        Rcpp::warning("Could not write landscape cache file %s", filename);
+        return;
+    }
+    CacheWriter w(out);
+
+    CacheHeader header {};
+    std::memcpy(header.magic, magic, sizeof magic);
+    header.version = version;
+    header.byteOrder = byteOrderMark;
+    header.key = key;
+    w.put(header);
+
+    w.put<int32_t>(xmx);
+    w.put<int32_t>(ymx);
+    w.put<int32_t>(block_size);
+    for (int s = 0; s < 4; ++s) w.put(meanMaxent[s]);
+
+    w.put<int64_t>(landscape.ncell());
+    for (int c = 0; c < Landscape::nColumn; ++c) {
+        w.align();
+        w.write(landscape.column(c), landscape.ncell() * sizeof(uint32_t));
+    }
+    w.put(water.cells());
+    w.put(Patches);
+
+    w.put<uint64_t>(Blocks.size());
+    for (const auto& block : Blocks) {
+        BlockRecord record;
+        record.id = block.m_id;
+        record.center[0] = block.m_center.x;
+        record.center[1] = block.m_center.y;
+        for (int s = 0; s < 4; ++s) {
+            record.totalFood[s] = block.m_total_food[s];
+            record.density[s] = block.m_density[s];
+            record.value[s] = block.m_value[s];
+        }
+        record.xmin = block.m_block_xmin;
+        record.xmax = block.m_block_xmax;
+        record.ymin = block.m_block_ymin;
+        record.ymax = block.m_block_ymax;
+        w.put(record);
+        w.put(block.m_cells);
+        w.put(block.m_patches);
+    }
+
+    w.put<uint64_t>(abundanceRegions.size());
+    for (const auto& region : abundanceRegions) {
+        w.put<int32_t>(region._id);
+        w.put(region._cells);
+    }
+
+    w.put<uint64_t>(FisheryBlocks.size());
+    for (const auto& fisheryCells : FisheryBlocks) w.put(fisheryCells);
+    w.put(emptyFisheryBlocks);
+
+    out.close();
+    if (!out || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        Rcpp::warning("Could not write landscape cache file %s", filename);
+    }
+}
+
+// Reads the preprocessed landscape. If share is true, the cell arrays are used in place
+// from the mapped file, otherwise they are copied.
+bool Settings::loadLandscapeCache(const std::string& filename, uint64_t key, bool share) {
+    std::unique_ptr<MappedFile> file(new MappedFile());
+    if (!file->open(filename)) return false;
+    const char* base = file->data();
+    CacheReader r(base, file->size());
+
+    CacheHeader header;
+    if (!r.get(header) || std::memcmp(header.magic, magic, sizeof magic) != 0 || header.version != version
+            || header.byteOrder != byteOrderMark || header.key != key) {
+        return false;
+    }
+
+    // read everything before touching the simulation, so a bad file leaves it as it was
+    int32_t x = 0, y = 0, bsize = 0;
+    float meanMaxent[4];
+    int64_t ncell = 0;
+    const void* columns[Landscape::nColumn] {};
+    std::vector<int> traversable, patches, emptyFishery;
+    bool ok = r.get(x) && r.get(y) && r.get(bsize);
+    for (int s = 0; s < 4; ++s) ok = ok && r.get(meanMaxent[s]);
+    ok = ok && r.get(ncell) && ncell == (int64_t) x * y;
+    for (int c = 0; ok && c < Landscape::nColumn; ++c) {
+        r.align(base);
+        columns[c] = r.take(ncell * sizeof(uint32_t));
+        ok = columns[c] != nullptr;
+    }
+    ok = ok && r.get(traversable) && r.get(patches);
+    for (size_t i = 0; ok && i < traversable.size(); ++i) {
+        ok = traversable[i] >= 0 && traversable[i] < ncell && (i == 0 || traversable[i] > traversable[i - 1]);
+    }
+    // patches, and the cells of blocks and regions, are indices of traversable cells
+    // (in Grid and water), and fishery cells are cell numbers
+    auto inRange = [](const std::vector<int>& values, int64_t n) {
+        for (int v : values) {
+            if (v < 0 || v >= n) return false;
+        }
+        return true;
+    };
+    const int64_t nTraversable = traversable.size();
+    ok = ok && inRange(patches, nTraversable);
+
+    uint64_t nBlock = 0, nRegion = 0, nFishery = 0;
+    std::vector<BlockRecord> blockRecords;
+    std::vector<std::vector<int>> blockCells, blockPatches, regionCells, fisheryCells;
+    std::vector<int32_t> regionIds;
+
+    ok = ok && r.get(nBlock) && nBlock <= (uint64_t) ncell;
+    for (uint64_t b = 0; ok && b < nBlock; ++b) {
+        BlockRecord record;
+        blockCells.emplace_back();
+        blockPatches.emplace_back();
+        ok = r.get(record) && r.get(blockCells.back()) && r.get(blockPatches.back())
+             && inRange(blockCells.back(), nTraversable) && inRange(blockPatches.back(), nTraversable);
+        blockRecords.push_back(record);
+    }
+    ok = ok && r.get(nRegion) && nRegion <= (uint64_t) ncell;
+    for (uint64_t a = 0; ok && a < nRegion; ++a) {
+        int32_t id;
+        regionCells.emplace_back();
+        ok = r.get(id) && r.get(regionCells.back()) && inRange(regionCells.back(), nTraversable);
+        regionIds.push_back(id);
+    }
+    ok = ok && r.get(nFishery) && nFishery <= (uint64_t) ncell;
+    for (uint64_t f = 0; ok && f < nFishery; ++f) {
+        fisheryCells.emplace_back();
+        ok = r.get(fisheryCells.back()) && inRange(fisheryCells.back(), ncell);
+    }
+    ok = ok && r.get(emptyFishery) && inRange(emptyFishery, nFishery + emptyFishery.size()) && r.atEnd();
+    if (!ok) return false;
+
+    initData(x, y, 0, 0, 0, 0, bsize, 0, meanMaxent[0], meanMaxent[1], meanMaxent[2], meanMaxent[3]);
+
+    if (share) {
+        landscape.attach(std::move(file), columns, ncell);
+    } else {
+        landscape.resize(ncell);
+        for (int c = 0; c < Landscape::nColumn; ++c) {
+            Landscape::Column column = Landscape::Column(c);
+            std::memcpy(landscape.floats(column), columns[c], ncell * sizeof(uint32_t));
+        }
+    }
+
+    // the food in grid cells is set up for the starting season by reset()
+    Grid.clear();
+    Grid.reserve(traversable.size());
+    for (int cell : traversable) {
+        water.add(cell);
+        Grid.emplace_back(cell);
+    }
+    water.finish();
+    Patches.swap(patches);
+
+    Blocks.assign(nBlock, Block());
+    for (uint64_t b = 0; b < nBlock; ++b) {
+        Block& block = Blocks[b];
+        const BlockRecord& record = blockRecords[b];
+        block.m_id = record.id;
+        block.m_center = Vector2df(record.center[0], record.center[1]);
+        block.m_cells.swap(blockCells[b]);
+        block.m_patches.swap(blockPatches[b]);
+        block.m_cellcount = block.m_cells.size();
+        block.m_patchcount = block.m_patches.size();
+        for (int s = 0; s < 4; ++s) {
+            block.m_total_food[s] = record.totalFood[s];
+            block.m_density[s] = record.density[s];
+            block.m_value[s] = record.value[s];
+        }
+        block.m_block_xmin = record.xmin;
+        block.m_block_xmax = record.xmax;
+        block.m_block_ymin = record.ymin;
+        block.m_block_ymax = record.ymax;
+    }
+
+    abundanceRegions.assign(nRegion, abundanceRegion());
+    for (uint64_t a = 0; a < nRegion; ++a) {
+        abundanceRegions[a]._id = regionIds[a];
+        abundanceRegions[a]._cells.swap(regionCells[a]);
+    }
+
+    FisheryBlocks.swap(fisheryCells);
+    emptyFisheryBlocks.swap(emptyFishery);
+
+    nBlocks = Blocks.size();
+    nSurveyBlocks = abundanceRegions.size();
+    nFisheryBlocks = FisheryBlocks.size();
+    return true;
+}
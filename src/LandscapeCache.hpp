@@ -0,0 +1,18 @@
+#ifndef __LANDSCAPECACHE__
+#define __LANDSCAPECACHE__
+#include <cstdint>
+#include <string>
+
+// Key of the preprocessed landscape for a landscape file and the parameters used in
+// preprocessing. 0 if the landscape file can't be read.
+uint64_t landscapeCacheKey(const std::string& sasc, float minimumWaterDepth, float maxU);
+
+// name of the cache file for a key in the cache directory
+std::string landscapeCacheFile(const std::string& dir, uint64_t key);
+
+// name of the tile file (see TileCache) for a key in the cache directory
+std::string landscapeTileFile(const std::string& dir, uint64_t key);
+
+// Settings::saveLandscapeCache and Settings::loadLandscapeCache are in LandscapeCache.cpp
+
+#endif // __LANDSCAPECACHE__
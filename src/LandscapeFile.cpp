@@ -0,0 +1,356 @@
+#include <Rcpp.h>
+#include <cstring>
+#include <cstdlib>
+#include <fstream>
+#include <string>
+#include <vector>
+#include "LandscapeFile.hpp"
+#include "TextFile.hpp"
+
+const char* LandscapeFile::columnNames[nColumn] = { "bathymetry", "distToCoast", "abundanceRegion", "fisheryRegion", "block",
+                                                    "foodLevel", "maxent1", "maxent2", "maxent3", "maxent4" };
+
+static const char magic[8] = { 'P', 'O', 'S', 'I', 'M', 'L', 'N', 'D' };
+static const uint32_t byteOrderMark = 0x01020304;
+static const size_t alignment = 64;
+enum { typeFloat = 0, typeInt = 1 };
+enum { stored = 0, runLength = 1 };
+
+struct FileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder; // byteOrderMark, as written by the machine that wrote the file
+    int64_t ncell;
+    LandscapeHeader landscape;
+};
+
+struct ColumnEntry {
+    uint32_t type;
+    uint32_t compression;
+    uint64_t offset; // from the start of the file
+    uint64_t bytes;
+};
+
+// header from its 12 values, in the order of the sasc header line
+static LandscapeHeader makeHeader(const double* v) {
+    LandscapeHeader h;
+    h.xmx = v[0];
+    h.ymx = v[1];
+    h.nsurv = v[2];
+    h.nfish = v[3];
+    h.nblock = v[4];
+    h.ntrav = v[5];
+    h.bsize = v[6];
+    h.npatch = v[7];
+    for (int i = 0; i < 4; ++i) h.meanMaxent[i] = v[8 + i];
+    return h;
+}
+
+static size_t alignUp(size_t n) {
+    return (n + alignment - 1) / alignment * alignment;
+}
+
+// run-length encoding of 4-byte values, as (count, value) pairs
+static std::vector<uint32_t> encodeRuns(const uint32_t* values, int64_t n) {
+    std::vector<uint32_t> runs;
+    int64_t i = 0;
+    while (i < n) {
+        int64_t j = i + 1;
+        while (j < n && values[j] == values[i] && j - i < UINT32_MAX) ++j;
+        runs.push_back(j - i);
+        runs.push_back(values[i]);
+        i = j;
+    }
+    return runs;
+}
+
+// returns false unless the runs decode to exactly n values
+static bool decodeRuns(const uint32_t* runs, size_t nWords, uint32_t* out, int64_t n) {
+    int64_t i = 0;
+    for (size_t w = 0; w + 1 < nWords; w += 2) {
+        if (i + runs[w] > n) return false;
+        std::fill(out + i, out + i + runs[w], runs[w + 1]);
+        i += runs[w];
+    }
+    return i == n;
+}
+
+bool LandscapeFile::isBinary(const std::string& filename) {
+    std::ifstream fid(filename, std::ios::in | std::ios::binary);
+    char start[sizeof magic] {};
+    fid.read(start, sizeof start);
+    return fid.gcount() == sizeof start && std::memcmp(start, magic, sizeof magic) == 0;
+}
+
+void LandscapeFile::read(const std::string& filename) {
+    if (isBinary(filename)) {
+        readBinary(filename);
+    } else {
+        readText(filename);
+    }
+}
+
+void LandscapeFile::setColumn(int column, const std::vector<uint32_t>& values) {
+    m_owned[column] = values;
+    m_columns[column] = m_owned[column].data();
+}
+
+void LandscapeFile::readText(const std::string& filename) {
+    TextFile text;
+    if (!text.open(filename)) {
+        // throw error in R and stop further execution
+        Rcpp::stop("read_gis: Could not open file for reading.");
+    }
+
+    TextFile::Fields fields = text.header();
+    if (fields.n != 12) {
+        Rcpp::stop("Bad header in %s: wanted 12 columns, got %d", filename, fields.n);
+    }
+    double values[12];
+    for (int i = 0; i < 12; ++i) {
+        int32_t n = 0;
+        float x = 0;
+        bool ok = i < 8 ? fields.getInt(i, n) : fields.getFloat(i, x);
+        if (!ok) {
+            Rcpp::stop("Bad header in %s: column %d is not a number", filename, i + 1);
+        }
+        values[i] = i < 8 ? n : x;
+    }
+    header = makeHeader(values);
+
+    ncell = text.nRow();
+    if (ncell != (int64_t) header.xmx * header.ymx) {
+        Rcpp::stop("%s has %d cells, header says %d x %d", filename, (int) ncell, header.xmx, header.ymx);
+    }
+    uint32_t* columns[nColumn];
+    for (int c = 0; c < nColumn; ++c) {
+        m_owned[c].resize(ncell);
+        columns[c] = m_owned[c].data();
+        m_columns[c] = columns[c];
+    }
+
+    // each row goes straight into its place in the columns
+    TextFile::Error error = text.parse(nColumn, nColumn, [&columns](int64_t row, const TextFile::Fields& fields) {
+        for (int c = 0; c < nColumn; ++c) {
+            bool ok;
+            if (isIntColumn(c)) {
+                int32_t value = 0;
+                ok = fields.getInt(c, value);
+                std::memcpy(&columns[c][row], &value, sizeof value);
+            } else {
+                float value = 0;
+                ok = fields.getFloat(c, value);
+                std::memcpy(&columns[c][row], &value, sizeof value);
+            }
+            if (!ok) return false;
+        }
+        return true;
+    });
+
+    if (error.badCount) {
+        Rcpp::stop("Bad data on line %d of %s: wanted 10 columns, got %d", (int) error.line, filename, error.nField);
+    } else if (error.line != -1) {
+        Rcpp::stop("Bad data on line %d of %s: not a number", (int) error.line, filename);
+    }
+}
+
+void LandscapeFile::readBinary(const std::string& filename, bool columns) {
+    if (!m_file.open(filename)) {
+        Rcpp::stop("read_gis: Could not open file for reading.");
+    }
+    const char* data = m_file.data();
+    const size_t size = m_file.size();
+    const size_t directoryEnd = sizeof(FileHeader) + nColumn * sizeof(ColumnEntry);
+    if (size < directoryEnd) {
+        Rcpp::stop("%s is not a landscape file: too short", filename);
+    }
+
+    FileHeader fh;
+    std::memcpy(&fh, data, sizeof fh);
+    if (std::memcmp(fh.magic, magic, sizeof magic) != 0) {
+        Rcpp::stop("%s is not a landscape file", filename);
+    }
+    if (fh.byteOrder != byteOrderMark) {
+        Rcpp::stop("%s was written on a machine with a different byte order. Convert it again from the sasc file.", filename);
+    }
+    if (fh.version != version) {
+        Rcpp::stop("%s has landscape format version %d, but this version of posim reads version %d", filename, (int) fh.version, (int) version);
+    }
+    header = fh.landscape;
+    ncell = fh.ncell;
+    if (ncell != (int64_t) header.xmx * header.ymx) {
+        Rcpp::stop("%s has %d cells, header says %d x %d", filename, (int) ncell, header.xmx, header.ymx);
+    }
+    if (!columns) return;
+
+    for (int c = 0; c < nColumn; ++c) {
+        ColumnEntry entry;
+        std::memcpy(&entry, data + sizeof(FileHeader) + c * sizeof(ColumnEntry), sizeof entry);
+
+        uint32_t type = isIntColumn(c) ? typeInt : typeFloat;
+        if (entry.type != type || entry.offset % alignment != 0 || entry.offset + entry.bytes > size) {
+            Rcpp::stop("Bad directory entry for column %s in %s", columnNames[c], filename);
+        }
+        const char* column = data + entry.offset;
+
+        if (entry.compression == stored) {
+            if (entry.bytes != ncell * sizeof(uint32_t)) {
+                Rcpp::stop("Column %s in %s has %d bytes, wanted %d", columnNames[c], filename, (int) entry.bytes, (int) (ncell * sizeof(uint32_t)));
+            }
+            m_columns[c] = column; // used in place
+        } else if (entry.compression == runLength) {
+            m_owned[c].resize(ncell);
+            if (!decodeRuns(reinterpret_cast<const uint32_t*>(column), entry.bytes / sizeof(uint32_t), m_owned[c].data(), ncell)) {
+                Rcpp::stop("Column %s in %s does not decode to %d values", columnNames[c], filename, (int) ncell);
+            }
+            m_columns[c] = m_owned[c].data();
+        } else {
+            Rcpp::stop("Column %s in %s uses unknown compression %d", columnNames[c], filename, (int) entry.compression);
+        }
+    }
+}
+
+void LandscapeFile::writeBinary(const std::string& filename, bool compress) const {
+    if (ncell != (int64_t) header.xmx * header.ymx) {
+        Rcpp::stop("Landscape for %s has %d cells, header says %d x %d", filename, (int) ncell, header.xmx, header.ymx);
+    }
+    // encode columns, and lay them out after the directory
+    std::vector<uint32_t> runs[nColumn];
+    ColumnEntry entries[nColumn];
+    size_t offset = alignUp(sizeof(FileHeader) + nColumn * sizeof(ColumnEntry));
+
+    for (int c = 0; c < nColumn; ++c) {
+        const uint32_t* values = static_cast<const uint32_t*>(m_columns[c]);
+        entries[c].type = isIntColumn(c) ? typeInt : typeFloat;
+        entries[c].compression = stored;
+        entries[c].bytes = ncell * sizeof(uint32_t);
+        if (compress) {
+            runs[c] = encodeRuns(values, ncell);
+            if (runs[c].size() * 2 <= (size_t) ncell) {
+                entries[c].compression = runLength;
+                entries[c].bytes = runs[c].size() * sizeof(uint32_t);
+            }
+        }
+        entries[c].offset = offset;
+        offset = alignUp(offset + entries[c].bytes);
+    }
+
+    std::ofstream fid(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!fid.is_open()) {
+        Rcpp::stop("Could not open %s for writing", filename);
+    }
+
+    FileHeader fh {};
+    std::memcpy(fh.magic, magic, sizeof magic);
+    fh.version = version;
+    fh.byteOrder = byteOrderMark;
+    fh.ncell = ncell;
+    fh.landscape = header;
+    fid.write(reinterpret_cast<const char*>(&fh), sizeof fh);
+    fid.write(reinterpret_cast<const char*>(entries), sizeof entries);
+
+    const std::vector<char> padding(alignment, 0);
+    size_t pos = sizeof fh + sizeof entries;
+    for (int c = 0; c < nColumn; ++c) {
+        fid.write(padding.data(), entries[c].offset - pos);
+        const char* bytes = entries[c].compression == runLength ? reinterpret_cast<const char*>(runs[c].data())
+                                                                : static_cast<const char*>(m_columns[c]);
+        fid.write(bytes, entries[c].bytes);
+        pos = entries[c].offset + entries[c].bytes;
+    }
+
+    if (!fid) {
+        Rcpp::stop("Error writing %s", filename);
+    }
+}
+
+//' Convert a sasc file to a binary landscape file
+//'
+//' Binary landscape files hold the same data as sasc files, but are read
+//' by \code{\link{posim}} without parsing, so that simulations start much
+//' faster on large landscapes. They can be used wherever a sasc file is expected.
+//'
+//' @param sasc Path to the sasc file to convert.
+//' @param filename Path of the binary landscape file to write.
+//' @param compress Logical. Run-length encode columns with long runs of equal values (e.g. regions and blocks).
+//' @seealso [posim::sasc()], which writes binary landscape files directly with \code{binary = TRUE}.
+//' @export
+// [[Rcpp::export]]
+void sasc_to_binary(std::string sasc, std::string filename, bool compress = true) {
+    LandscapeFile landscape;
+    landscape.readText(sasc);
+    landscape.writeBinary(filename, compress);
+}
+
+// writes a binary landscape file from the header values and columns assembled by sasc()
+// [[Rcpp::export]]
+void write_binary_sasc(std::string filename, Rcpp::NumericVector header, Rcpp::List columns, bool compress) {
+    if (header.size() != 12 || columns.size() != LandscapeFile::nColumn) {
+        Rcpp::stop("write_binary_sasc: wanted 12 header values and %d columns", LandscapeFile::nColumn);
+    }
+    LandscapeFile landscape;
+    landscape.header = makeHeader(header.begin());
+    landscape.ncell = (int64_t) landscape.header.xmx * landscape.header.ymx;
+
+    for (int c = 0; c < LandscapeFile::nColumn; ++c) {
+        Rcpp::NumericVector x = columns[c];
+        if (x.size() != landscape.ncell) {
+            Rcpp::stop("write_binary_sasc: column %s has %d cells, header says %d x %d", LandscapeFile::columnNames[c], (int) x.size(),
+                       landscape.header.xmx, landscape.header.ymx);
+        }
+        std::vector<uint32_t> values(x.size());
+        for (int i = 0; i < x.size(); ++i) {
+            if (LandscapeFile::isIntColumn(c)) {
+                int32_t value = x[i];
+                std::memcpy(&values[i], &value, sizeof value);
+            } else {
+                float value = x[i];
+                std::memcpy(&values[i], &value, sizeof value);
+            }
+        }
+        landscape.setColumn(c, values);
+    }
+    landscape.writeBinary(filename, compress);
+}
+
+// the header values, named as the columns of the sasc header read in R
+static Rcpp::NumericVector headerValues(const LandscapeHeader& h) {
+    return Rcpp::NumericVector::create(
+        Rcpp::Named("xmax") = h.xmx, Rcpp::Named("ymax") = h.ymx, Rcpp::Named("nabund") = h.nsurv,
+        Rcpp::Named("nfish") = h.nfish, Rcpp::Named("nblock") = h.nblock, Rcpp::Named("ntrav") = h.ntrav,
+        Rcpp::Named("block_size") = h.bsize, Rcpp::Named("nfood") = h.npatch,
+        Rcpp::Named("maxent1") = h.meanMaxent[0], Rcpp::Named("maxent2") = h.meanMaxent[1],
+        Rcpp::Named("maxent3") = h.meanMaxent[2], Rcpp::Named("maxent4") = h.meanMaxent[3]);
+}
+
+// reads a binary landscape file into a list of the header and a data frame of the columns
+// [[Rcpp::export]]
+Rcpp::List read_binary_sasc(std::string filename) {
+    LandscapeFile landscape;
+    landscape.readBinary(filename);
+    Rcpp::NumericVector header = headerValues(landscape.header);
+
+    Rcpp::List data(LandscapeFile::nColumn);
+    Rcpp::CharacterVector names(LandscapeFile::nColumn);
+    for (int c = 0; c < LandscapeFile::nColumn; ++c) {
+        if (LandscapeFile::isIntColumn(c)) {
+            const int32_t* x = landscape.ints(c);
+            data[c] = Rcpp::IntegerVector(x, x + landscape.ncell);
+        } else {
+            const float* x = landscape.floats(c);
+            data[c] = Rcpp::NumericVector(x, x + landscape.ncell);
+        }
+        names[c] = LandscapeFile::columnNames[c];
+    }
+    data.attr("names") = names;
+
+    return Rcpp::List::create(Rcpp::Named("header") = header, Rcpp::Named("data") = Rcpp::DataFrame(data));
+}
+
+// reads only the header of a binary landscape file, as given by read_binary_sasc
+// [[Rcpp::export]]
+Rcpp::NumericVector read_binary_sasc_header(std::string filename) {
+    LandscapeFile landscape;
+    landscape.readBinary(filename, false);
+    return headerValues(landscape.header);
+}
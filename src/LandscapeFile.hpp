@@ -0,0 +1,57 @@
+#ifndef __LANDSCAPEFILE__
+#define __LANDSCAPEFILE__
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "MappedFile.hpp"
+
+// metadata of a landscape (the first line of a sasc file)
+struct LandscapeHeader {
+    int32_t xmx, ymx, nsurv, nfish, nblock, ntrav, bsize, npatch;
+    float meanMaxent[4];
+};
+
+/*
+ * The columns of a landscape, one value per cell, read from either a sasc text
+ * file or a binary landscape file.
+ *
+ * Binary landscape files start with a fixed header (magic "POSIMLND", format
+ * version, a byte order mark, the number of cells and the LandscapeHeader),
+ * followed by a directory giving the type, compression, offset and size of each
+ * column, and then the columns themselves, each a contiguous array of 4-byte
+ * values aligned to 64 bytes. A column is either stored as is, and then used
+ * directly from the memory-mapped file, or run-length encoded as (count, value)
+ * pairs, and then decoded on reading. Columns with long runs (regions, blocks)
+ * are compressed when that saves at least half their size.
+ */
+class LandscapeFile {
+public:
+    enum Column { bathymetry, distToCoast, abundanceRegion, fisheryRegion, block, foodLevel, maxent1, maxent2, maxent3, maxent4 };
+    static const int nColumn = 10;
+    static const char* columnNames[nColumn];
+    static bool isIntColumn(int column) { return column >= abundanceRegion && column <= block; }
+
+    static const uint32_t version = 1;
+    static bool isBinary(const std::string& filename);
+
+    LandscapeHeader header {};
+    int64_t ncell { 0 };
+
+    void readText(const std::string& filename);
+    void readBinary(const std::string& filename, bool columns = true); // only the header unless columns
+    void read(const std::string& filename); // either format
+    void writeBinary(const std::string& filename, bool compress) const;
+
+    // sets a column from a copy of the given values
+    void setColumn(int column, const std::vector<uint32_t>& values);
+
+    const float* floats(int column) const { return static_cast<const float*>(m_columns[column]); }
+    const int32_t* ints(int column) const { return static_cast<const int32_t*>(m_columns[column]); }
+
+private:
+    MappedFile m_file;
+    std::vector<uint32_t> m_owned[nColumn]; // columns that were parsed or decoded, rather than mapped
+    const void* m_columns[nColumn] {};
+};
+
+#endif // __LANDSCAPEFILE__
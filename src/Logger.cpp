@@ -18,8 +18,8 @@ void Logger::log(int step, const std::unique_ptr<Porpoise>& porp) {
     if ((m_follow.size() == 1 && m_follow[0] == 0) || std::find(m_follow.begin(), m_follow.end(), porp->Id) != m_follow.end()) {
         m_step.push_back(step);
         m_id.push_back(porp->Id);
-        m_x.push_back(porp->track.front().pos.x);
-        m_y.push_back(porp->track.front().pos.y);
+        m_x.push_back(porp->track.pos(0).x);
+        m_y.push_back(porp->track.pos(0).y);
         m_cell.push_back(porp->currentCell);
         m_prev_mov.push_back(pow(10, porp->prev_logmov)*100);
         m_age.push_back(porp->Age);
@@ -14,9 +14,6 @@ class Porpoise;
 class Gillnet;
 class Timer;
 
-extern int DEBUG_LEVEL;
-
-
 class Logger {
 private:
     Rcpp::List m_log;
@@ -96,24 +93,13 @@ public:
     }
     void bycatch(int count);
     void gillnet_set(int count);
+    bool following() const { return m_follow.size() > 0 && m_follow[0] != -1; } // are any porpoises tracked?
     void log(int step, const std::unique_ptr<Porpoise>& porp);
     void log(int step, Gillnet *gn);
     void log(int step, int ageClass, int N, int type);
     void log(int step, int abundanceRegion, int N, int births, int deaths, int bycatch);
     void log(int step, int N, float food, float energy);
     void log(int year, int month, int day, int block, int type, int count, float x, float y);
-    // this must be defined here, because otherwise the function will have internal linkage
-    template <typename... Args>
-    static void debug(int level, const char* format, Args... args) {
-        // has to be implement in header file; don't know why.https://open.spotify.com/show/5UTquk3eIW8u9xRV4tnt49
-        if (DEBUG_LEVEL < level) return;
-        
-        std::string formatAsString = "";
-        formatAsString += format;
-        formatAsString += "\n";
-        Rprintf(formatAsString.c_str(), args...);
-    };
-    
     void clear();
     Rcpp::List toList(); 
 };
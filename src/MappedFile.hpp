@@ -0,0 +1,80 @@
+#ifndef __MAPPEDFILE__
+#define __MAPPEDFILE__
+#include <string>
+#include <vector>
+#include <cstddef>
+#include <fstream>
+#include <iterator>
+
+#if !defined(WIN32) && !defined(__WIN32) && !defined(__WIN32__)
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define POSIM_MMAP
+#endif
+
+/*
+ * Read-only view of a whole file. On unix-alikes the file is memory-mapped, so
+ * nothing is read until it is touched, and pages are shared with the OS cache.
+ * Elsewhere the file is read into memory.
+ */
+class MappedFile {
+private:
+    const char* m_data { nullptr };
+    size_t m_size { 0 };
+    std::vector<char> m_buffer; // file contents, if not mapped
+
+public:
+    MappedFile() = default;
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+    ~MappedFile() { close(); }
+
+    // returns false if the file can't be opened
+    bool open(const std::string& filename) {
+        close();
+#ifdef POSIM_MMAP
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd == -1) return false;
+        struct stat st;
+        if (fstat(fd, &st) == -1) {
+            ::close(fd);
+            return false;
+        }
+        m_size = st.st_size;
+        if (m_size > 0) {
+            void* p = mmap(nullptr, m_size, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p == MAP_FAILED) {
+                ::close(fd);
+                m_size = 0;
+                return false;
+            }
+            m_data = static_cast<const char*>(p);
+        }
+        ::close(fd); // the mapping stays valid
+        return true;
+#else
+        std::ifstream fid(filename, std::ios::in | std::ios::binary);
+        if (!fid.is_open()) return false;
+        m_buffer.assign(std::istreambuf_iterator<char>(fid), std::istreambuf_iterator<char>());
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+        return true;
+#endif
+    }
+
+    void close() {
+#ifdef POSIM_MMAP
+        if (m_data != nullptr) munmap(const_cast<char*>(m_data), m_size);
+#endif
+        m_buffer.clear();
+        m_data = nullptr;
+        m_size = 0;
+    }
+
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+};
+
+#endif // __MAPPEDFILE__
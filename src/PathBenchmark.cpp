@@ -0,0 +1,130 @@
+#include <Rcpp.h>
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <string>
+#include <vector>
+#include "pcg_random.hpp"
+#include "Settings.hpp"
+#include "GridCell.hpp"
+
+// side of the tiles of the tiled path grid: 64 x 64 one-byte cells fill one 4 KiB page
+static const int tileShift = 6;
+static const int tileSize = 1 << tileShift;
+
+// checks paths (x, y, newX, newY, one after the other) with check, and returns the
+// number found traversable, and the time taken
+template<class F>
+static int checkPaths(const std::vector<float>& paths, F check, double& seconds) {
+    auto start = std::chrono::steady_clock::now();
+    int count = 0;
+    for (size_t i = 0; i < paths.size(); i += 4) {
+        count += check(paths[i], paths[i + 1], paths[i + 2], paths[i + 3]);
+    }
+    seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return count;
+}
+
+//' Time path checks on a landscape
+//'
+//' Times the check of whether a straight path crosses land, as done for every
+//' porpoise move, for random paths starting in water. The paths are checked with
+//' the cell numbers of the crossed cells and the water depth of the landscape, as
+//' done before path checks used a separate grid; with the row-major padded grid
+//' used in simulations; and with the same grid stored in tiles of 64 x 64 cells,
+//' so that paths crossing many rows touch fewer pages and cache lines.
+//'
+//' @param landscape A landscape loaded with \code{\link{load_landscape}}.
+//' @param n Number of paths.
+//' @param maxDistance Maximum length of paths, in cells. The length of each path
+//' is uniformly distributed between 0 and maxDistance.
+//' @param seed Seed for the random paths.
+//' @return A data frame with one row per grid layout, giving the time taken,
+//' the paths checked per second, and the number of paths found traversable,
+//' which is the same for all layouts.
+//' @export
+// [[Rcpp::export]]
+Rcpp::DataFrame benchmark_paths(SEXP landscape, int n = 1000000, double maxDistance = 15, int seed = 1) {
+    if (!Rf_inherits(landscape, "posim_landscape")) Rcpp::stop("landscape must be loaded with load_landscape()");
+    Rcpp::XPtr<Settings> ptr(landscape);
+    if (!ptr.get()) Rcpp::stop("landscape is no longer loaded; call load_landscape() again");
+    Settings& sim = *ptr.get();
+    if (sim.water.size() == 0) Rcpp::stop("The landscape has no traversable cells");
+
+    // paths from random points in traversable cells, in random directions
+    pcg32 rng(seed);
+    std::uniform_int_distribution<int> randomCell(0, sim.water.size() - 1);
+    std::uniform_real_distribution<float> unif(0.0f, 1.0f);
+    std::vector<float> paths;
+    paths.reserve(4 * (size_t) n);
+    for (int i = 0; i < n; ++i) {
+        Vector2df start = sim.pointFromCell(sim.water.cell(randomCell(rng)));
+        start.x += unif(rng) - 0.5f;
+        start.y += unif(rng) - 0.5f;
+        float angle = unif(rng) * 2 * PI;
+        float distance = unif(rng) * maxDistance;
+        paths.push_back(start.x);
+        paths.push_back(start.y);
+        paths.push_back(start.x + std::sin(angle) * distance);
+        paths.push_back(start.y + std::cos(angle) * distance);
+    }
+
+    // the path grid of the simulation, in tiles
+    const int width = sim.pathGridWidth;
+    const int height = sim.pathGrid.size() / width;
+    const int tilesX = (width + tileSize - 1) / tileSize;
+    const int tilesY = (height + tileSize - 1) / tileSize;
+    std::vector<uint8_t> tiled((size_t) tilesX * tilesY * tileSize * tileSize, Settings::PathOffGrid);
+    for (int r = 0; r < height; ++r) {
+        for (int c = 0; c < width; ++c) {
+            size_t tile = (size_t) (r >> tileShift) * tilesX + (c >> tileShift);
+            tiled[(tile << (2 * tileShift)) + ((r & (tileSize - 1)) << tileShift) + (c & (tileSize - 1))] = sim.pathGrid[(size_t) r * width + c];
+        }
+    }
+
+    std::vector<std::string> layout;
+    std::vector<double> seconds, pathsPerSecond;
+    std::vector<int> traversable;
+    auto add = [&](std::string name, int count, double t) {
+        layout.push_back(name);
+        seconds.push_back(t);
+        pathsPerSecond.push_back(n / std::max(t, 1e-9));
+        traversable.push_back(count);
+    };
+    double t;
+    int count;
+
+    count = checkPaths(paths, [&](float x, float y, float newX, float newY) {
+        if (!sim.isCoordValid(Vector2df(newX, newY)) || !sim.isCoordValid(Vector2df(x, y))) return false;
+        for (int cell : sim.GetCellsIntersected(x, y, newX, newY)) {
+            if (cell == -1 ? !sim.offGridCellsTraversable : sim.landscape.bathymetry(cell) > sim.MinimumWaterDepth) return false;
+        }
+        return true;
+    }, t);
+    add("cell numbers", count, t);
+
+    count = checkPaths(paths, [&](float x, float y, float newX, float newY) {
+        return sim.IsPathTraversable(x, y, newX, newY);
+    }, t);
+    add("row-major", count, t);
+
+    const uint8_t pass = sim.offGridCellsTraversable ? Settings::PathWater | Settings::PathOffGrid : Settings::PathWater;
+    const int xmx = sim.xmx, ymx = sim.ymx, padding = Settings::pathGridPadding;
+    count = checkPaths(paths, [&](float x, float y, float newX, float newY) {
+        if (!sim.isCoordValid(Vector2df(newX, newY)) || !sim.isCoordValid(Vector2df(x, y))) return false;
+        bool ok = true;
+        forCellsIntersected(xmx, ymx, x, y, newX, newY, [&](int cx, int cy) {
+            int c = cx + padding;
+            int r = ymx - cy + padding;
+            size_t tile = (size_t) (r >> tileShift) * tilesX + (c >> tileShift);
+            ok = tiled[(tile << (2 * tileShift)) + ((r & (tileSize - 1)) << tileShift) + (c & (tileSize - 1))] & pass;
+            return ok;
+        });
+        return ok;
+    }, t);
+    add("tiled", count, t);
+
+    return Rcpp::DataFrame::create(Rcpp::Named("layout") = layout, Rcpp::Named("seconds") = seconds,
+                                   Rcpp::Named("pathsPerSecond") = pathsPerSecond, Rcpp::Named("traversable") = traversable,
+                                   Rcpp::Named("stringsAsFactors") = false);
+}
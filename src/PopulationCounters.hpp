@@ -0,0 +1,94 @@
+#ifndef __POPULATIONCOUNTERS__
+#define __POPULATIONCOUNTERS__
+#include <vector>
+#include "omp.h"
+
+/*
+ * Number of porpoises per abundance region, per block and per age class, with
+ * the births, deaths and bycatch per abundance region since the last output.
+ * The counts are kept up to date as porpoises change region or block, age
+ * into the next age class, are born or die (see Porpoise::updateCounters),
+ * instead of being counted from scratch whenever they are needed.
+ *
+ * Changes are recorded as per-thread deltas, so the porpoise loops need no
+ * atomics, and are added to the totals by reduce() at the end of each step.
+ */
+class PopulationCounters {
+public:
+    static const int nAgeClass = 3; // juvenile, adult, old
+
+    struct Counts {
+        std::vector<int> region, block;
+        int ageClass[nAgeClass] {};
+        std::vector<int> births, deaths, bycatch; // per abundance region
+
+        void reset(int nRegion, int nBlock) {
+            region.assign(nRegion, 0);
+            block.assign(nBlock, 0);
+            for (int a = 0; a < nAgeClass; ++a) ageClass[a] = 0;
+            births.assign(nRegion, 0);
+            deaths.assign(nRegion, 0);
+            bycatch.assign(nRegion, 0);
+        }
+    };
+
+private:
+    Counts m_total;
+    std::vector<Counts> m_delta; // per thread
+
+    static void add(std::vector<int>& counts, int i, int n) {
+        if (i >= 0 && i < (int) counts.size()) counts[i] += n;
+    }
+
+public:
+    void reset(int nRegion, int nBlock, int nThread) {
+        m_total.reset(nRegion, nBlock);
+        m_delta.resize(nThread);
+        for (auto& delta : m_delta) delta.reset(nRegion, nBlock);
+    }
+
+    // moves a porpoise from one region, block and age class to another. -1 is none,
+    // so (-1, -1, -1) as the origin adds a porpoise and as the destination removes it
+    void move(int fromRegion, int fromBlock, int fromAgeClass, int toRegion, int toBlock, int toAgeClass) {
+        Counts& delta = m_delta[omp_get_thread_num()];
+        add(delta.region, fromRegion, -1);
+        add(delta.region, toRegion, 1);
+        add(delta.block, fromBlock, -1);
+        add(delta.block, toBlock, 1);
+        if (fromAgeClass != -1) delta.ageClass[fromAgeClass]--;
+        if (toAgeClass != -1) delta.ageClass[toAgeClass]++;
+    }
+    void birth(int region) { add(m_delta[omp_get_thread_num()].births, region, 1); }
+    void death(int region) { add(m_delta[omp_get_thread_num()].deaths, region, 1); }
+    void bycatch(int region) { add(m_delta[omp_get_thread_num()].bycatch, region, 1); }
+
+    // adds the deltas of all threads to the totals. Called by a single thread.
+    void reduce() {
+        for (auto& delta : m_delta) {
+            for (int r = 0; r < (int) m_total.region.size(); ++r) {
+                m_total.region[r] += delta.region[r];
+                m_total.births[r] += delta.births[r];
+                m_total.deaths[r] += delta.deaths[r];
+                m_total.bycatch[r] += delta.bycatch[r];
+            }
+            for (int b = 0; b < (int) m_total.block.size(); ++b) {
+                m_total.block[b] += delta.block[b];
+            }
+            for (int a = 0; a < nAgeClass; ++a) {
+                m_total.ageClass[a] += delta.ageClass[a];
+            }
+            delta.reset(m_total.region.size(), m_total.block.size());
+        }
+    }
+
+    // clears births, deaths and bycatch once they have been logged
+    void resetStats() {
+        m_total.births.assign(m_total.births.size(), 0);
+        m_total.deaths.assign(m_total.deaths.size(), 0);
+        m_total.bycatch.assign(m_total.bycatch.size(), 0);
+    }
+
+    const Counts& totals() const { return m_total; }
+};
+
+#endif // __POPULATIONCOUNTERS__
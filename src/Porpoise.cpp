@@ -3,6 +3,7 @@
 #include <iostream>
 #include <algorithm>
 #include <cmath>
+#include <functional>
 
 #include "Settings.hpp"
 #include "Porpoise.hpp"
@@ -12,45 +13,18 @@
 #include "Logger.h"
 #include "Block.hpp"
 #include "Position.hpp"
+#include "CRWKernel.hpp"
+#include "Samplers.hpp"
+#include "FastMath.hpp"
 
 typedef std::pair<Vector2df, Vector2df> _linestring;
 
-// static porpoise variables
-std::vector<std::unique_ptr<Porpoise>> Porpoise::Porpoises;
-Settings* Porpoise::sim;
-int Porpoise::nextId;
-std::shared_ptr<Settings> Porpoise::Config;
-float Porpoise::AgeOfMaturity;
-float Porpoise::monthlyEnergyMultiplier[12];
-float Porpoise::withCalfEnergyMultiplier;
-float Porpoise::distEnergyMultiplier;
-float Porpoise::stepEnergyMultiplier;
-float Porpoise::m_mort_prob;
-float Porpoise::x_surv_prob;
-int Porpoise::dispersalInertia;
-float Porpoise::meanDispersalDistance;
-float Porpoise::minDispersalDistance;
-float Porpoise::maxDispersalDistance;
-float Porpoise::minDispersalDistanceSquared;
-float Porpoise::maxDispersalDistanceSquared;
-float Porpoise::minDispersalDepth;
-float Porpoise::minDispersalDistanceToLand;
-float Porpoise::pregnancy_prob;
-float Porpoise::max_age;
-int Porpoise::maxMemory;
-float Porpoise::inertia_const;
-float Porpoise::corrLogmov;
-float Porpoise::corrAngle;
-float Porpoise::m;
-float Porpoise::maxLogmov;
-std::vector<int> Porpoise::age_dist;
-std::vector<float> Porpoise::ref_mem_strength;
-std::vector<float> Porpoise::work_mem_strength;
+constexpr float Porpoise::dailyAging;
 
 // constructor for all porpoises in starting population
-Porpoise::Porpoise(int SurveyBlock) : Id(++nextId) {
+Porpoise::Porpoise(Settings* sim, int SurveyBlock) : sim(sim), Id(++sim->nextPorpoiseId) {
 
-    track.reserve(maxMemory);
+    track.reserve(sim->porpoise.maxMemory);
 
     // assign a random position to the porpoise (within the specified abundance block, if applicable)
     executeMove(sim->randomPoint(SurveyBlock), Heading, normalMove);
@@ -59,7 +33,7 @@ Porpoise::Porpoise(int SurveyBlock) : Id(++nextId) {
     int birthday = round(getRandomNormal(160, 20));
     
     // pick a random age class
-    Age = getRandomDiscrete(&age_dist);
+    Age = getRandomDiscrete(&sim->porpoise.age_dist);
 
     // increase age by some fraction of a year, corresponding to the time elapsed since the porp's birthday
     if (sim->time->yday() >= birthday) {
@@ -69,8 +43,8 @@ Porpoise::Porpoise(int SurveyBlock) : Id(++nextId) {
     }
     
     // if porp was mature last mating season, she may be pregnant with a calf
-    if ((Age-1) >= AgeOfMaturity) {
-        if (getRandomFloat(0, 1) < pregnancy_prob) {
+    if ((Age-1) >= sim->porpoise.AgeOfMaturity) {
+        if (getRandomFloat(0, 1) < sim->porpoise.pregnancy_prob) {
             float birth = getRandomNormal(160, 20);
             if (birth > sim->time->yday()) {
                 isPregnant = true;
@@ -79,7 +53,7 @@ Porpoise::Porpoise(int SurveyBlock) : Id(++nextId) {
         }
         
         // if porp was mature two mating seasons ago, she may be nursing a calf born last summer
-        if ((Age - 2) >= AgeOfMaturity && getRandomFloat(0, 1) < pregnancy_prob*0.5) {
+        if ((Age - 2) >= sim->porpoise.AgeOfMaturity && getRandomFloat(0, 1) < sim->porpoise.pregnancy_prob*0.5) {
             float wean = getRandomNormal(100, 20);
             if (wean > sim->time->yday()) {
                 withCalf = true;
@@ -91,15 +65,48 @@ Porpoise::Porpoise(int SurveyBlock) : Id(++nextId) {
     // set current energy usage according to time of year and calf status
     setEnergyUse();
     setMatingDay();
+    if (isPregnant) scheduleEvent(EventCalendar::birth, calfBirthday);
+    if (withCalf) scheduleEvent(EventCalendar::weaning, weaningDay);
+    scheduleAgeOut(EventCalendar::dayNumber(sim->time->year(), sim->time->yday()));
+    count();
 }
 
 // Calf constructor. Calves start out in the same location as their mother. 
-Porpoise::Porpoise(const Porpoise& mother) : Id(++nextId) {
-    track.reserve(maxMemory);
+Porpoise::Porpoise(const Porpoise& mother) : sim(mother.sim), Id(++sim->nextPorpoiseId) {
+    track.reserve(sim->porpoise.maxMemory);
     Age = 0.6777778f; // calves are weaned after 8 months
     executeMove(mother.currentPos, mother.Heading, normalMove);
     setEnergyUse();
     setMatingDay();
+    scheduleAgeOut(EventCalendar::dayNumber(sim->time->year(), sim->time->yday()));
+    count();
+}
+
+Porpoise::~Porpoise() {
+    sim->calendar.cancel(this, EventCalendar::mating, matingDay);
+    if (isPregnant) sim->calendar.cancel(this, EventCalendar::birth, calfBirthday);
+    if (withCalf) sim->calendar.cancel(this, EventCalendar::weaning, weaningDay);
+    sim->ageOuts.cancel(this, EventCalendar::ageOut, ageOutDay);
+}
+
+// removes porpoises by index, moving the last porpoise into each vacated place.
+// Going from the highest index down, the porpoise moved is never one to be removed.
+void Porpoise::add(Settings& sim, std::unique_ptr<Porpoise> porp) {
+    porp->index = sim.Porpoises.size();
+    sim.Porpoises.push_back(std::move(porp));
+}
+
+void Porpoise::remove(Settings& sim, std::vector<int>& indices) {
+    std::vector<std::unique_ptr<Porpoise>>& Porpoises = sim.Porpoises;
+    std::sort(indices.begin(), indices.end(), std::greater<int>());
+    for (const int& i : indices) {
+        Porpoises[i]->uncount();
+        if (i != (int) Porpoises.size() - 1) {
+            Porpoises[i] = std::move(Porpoises.back());
+            Porpoises[i]->index = i;
+        }
+        Porpoises.pop_back();
+    }
 }
 
 /***********************************************************************************************
@@ -120,63 +127,69 @@ void Porpoise::setHeading(float newHeading) {
     }
 }
 void Porpoise::executeMove(Vector2df newPos, float newHeading, PorpoiseMovementMode mode) {
+    const PorpoiseParameters& params = sim->porpoise;
     
     int newCell = sim->cellFromPoint(newPos);
     
     // catch rare bugs here: don't allow moves to illegal cells
-    if (newCell == -1 || sim->Grid[newCell].Bathymetry > sim->MinimumWaterDepth) {
+    if (newCell == -1 || sim->landscape.bathymetry(newCell) > sim->MinimumWaterDepth) {
         return; 
     }
 
     currentCell = newCell;
     lastPos = currentPos;
     currentPos = newPos;
+    if (sim->landscape.abundanceRegion(newCell) != countedRegion || sim->landscape.block(newCell) != countedBlock) updateCounters();
     
     if (mode == normalMove) {
-        track.emplace(track.begin(), newPos);
-        if (track.size() > maxMemory) track.resize(maxMemory);
+        // the new position shifts the track by one: the running sums decay by
+        // one step, and the oldest remembered position drops out of them
+        const int nTrack = track.size();
+        if (params.work_mem_decay.valid && params.work_mem_decay.window > 0) {
+            if (nTrack >= params.work_mem_decay.window) workMemorySum -= params.work_mem_decay.last * track.food(params.work_mem_decay.window - 1);
+            workMemorySum *= params.work_mem_decay.ratio;
+        }
+        if (params.ref_mem_decay.valid && params.ref_mem_decay.window > 0) {
+            if (nTrack >= params.ref_mem_decay.window) refMemorySum -= params.ref_mem_decay.last * track.food(params.ref_mem_decay.window - 1);
+            refMemorySum *= params.ref_mem_decay.ratio;
+        }
+        const int refWindow = std::min((int) params.ref_mem_strength.size(), params.maxMemory);
+        if (refWindow > 0 && nTrack >= refWindow && track.food(refWindow - 1) != 0) foodMemories--;
+        
+        track.push(newPos);
     }
 
     // update heading
     setHeading(newHeading);
-    //Logger::debug(0, " set heading to %.02f (moved from %.02f,%.02f to %.02f,%.02f", Heading, lastPos.x, lastPos.y, currentPos.x, currentPos.y);
+    //sim->debug(0, " set heading to %.02f (moved from %.02f,%.02f to %.02f,%.02f", Heading, lastPos.x, lastPos.y, currentPos.x, currentPos.y);
 }
 
 void Porpoise::intrinsicMove() {
-    
-    float expectedEnergy = calcExpectedEnergy();
-    float CRW_contrib = inertia_const + pres_mov * expectedEnergy; // emphasize CRW if food is plentiful
-    Vector2df foodAttraction = calcFoodAttractionVector(); // food attraction vector
-    Vector2df CRW = calcCRW() * CRW_contrib; // CRW component, scaled by expected foraging success
-    Vector2df mov = CRW + foodAttraction; // calculate the sum of CRW and food attraction
-    mov = mov.normalize() * (0.25f * pres_mov); // calculate unit vector, and multiply by pres_mov (and scale from 100m to 400m grid)
-    
-    // calculate new absolute position
-    Vector2df newPos = currentPos + mov;
-    // calculate turning angle of the new move, relative to current heading (subtract from 90 to get from x-axis to y-axis)
-    float newHeading = 90 - atan2(mov.y, mov.x)*180/PI;
-    pres_angle = newHeading - Heading;
-    if (pres_angle < -180.0f) pres_angle += 360;
-    if (pres_angle > 180.f) pres_angle -= 360;
-    
-    //Logger::debug(0, "mov: %.02f,%.02f, current heading: %.02f, new heading: %.02f, turning angle: %.02f, adjusted turn: %.02f",
-     //            mov.x, mov.y, Heading, newHeading, old_angle, pres_angle);
-    
+    // a batch of one; the first half-hour pass moves foragers in full batches
+    CRWBatch batch;
+    batch.add(this);
+    batch.move();
+}
+
+// Final part of a CRW move, once pres_mov and pres_angle hold the step length
+// and the turn towards newPos
+void Porpoise::finishIntrinsicMove(Vector2df newPos) {
     // check if the new course would intersect with any cells that do not
     // have sufficient water depth, and make adjustments as needed
     sim->adjustMoveToAvoidShallowWater(this, newPos, pres_angle, pres_mov);
     this->prev_mov = pres_mov;
-    this->prev_logmov = log10(pres_mov);
+    this->prev_logmov = fastLog10(pres_mov);
     this->prev_angle = pres_angle;
-    //Logger::debug(0, " final turn = %.02f, final heading = %.02f", pres_angle, Heading + pres_angle);
+    //sim->debug(0, " final turn = %.02f, final heading = %.02f", pres_angle, Heading + pres_angle);
     
     // execute the move (heading recalculated because it may have changed)
     executeMove(newPos, Heading + pres_angle, normalMove);
 }
 
-// CRW: Correlated Random Walk. Calculates turning angle and move length with no
-// regard for current energy state or memory, which we'll add in later.
-Vector2df Porpoise::calcCRW() {
+// CRW: Correlated Random Walk. Draws turning angle and move length with no
+// regard for current energy state or memory, which are added in later. The
+// move itself is computed for a batch of porpoises at a time (see CRWBatch).
+void Porpoise::drawCRW() {
     
     // R1 = N(0.42, 0.48)       Log10 distance moved per time step (mean +/- 1 SD).
     // R2 = N(0, 38)            Turning angles between steps (mean +/- 1 SD).
@@ -186,97 +199,110 @@ Vector2df Porpoise::calcCRW() {
     
     // calculate turning angle. Turning angle should be negatively correlated
     // with the previous turning angle and, when prev_mov < m, with distance moved.
-    pres_angle = 999;
+    // Only angles within +/- 180 degrees are accepted, so the angle follows a
+    // truncated normal distribution, which is sampled directly.
     float tmp_angle = 0;
-    int j = 0;
     
     if (prev_angle < 0) {
         tmp_angle += 24;
     } else {
         tmp_angle -= 24;
     }
-    while (abs(pres_angle) > 180 && j < 200) {
-        pres_angle = tmp_angle * -1 * corrAngle + getRandomNormal(0, 38);
-        j++;
-        if (j == 200) {
-            pres_angle = pres_angle * 90 / abs(pres_angle);
-        }
-    }
+    pres_angle = getRandomTruncatedNormal(tmp_angle * -1 * sim->porpoise.corrAngle, 38, -180, 180);
     
     int sign = 1;
     if (pres_angle < 0) sign = -1;
     pres_angle = abs(pres_angle);
-    // make angle decrease linearly with mov_dist
-    bool go_on = true;
-    float rnd;
-    j = 0;
-    while (go_on == true && j < 200) {
-        rnd = getRandomNormal(96, 28);
-        if (prev_mov <= 5.5) pres_angle += rnd - (rnd*prev_mov/5.5);
-        if (pres_angle < 180) go_on = false;
-        j++;
-        if (j == 200) {
-            pres_angle = getRandomInt(0, 20) + 90;
-            go_on = false;
-        }
+    // make angle decrease linearly with mov_dist. If that takes the angle to
+    // 180 or more, drawing again only adds to it (rnd is practically always 
+    // positive), so the angle is set to 90-110 degrees, like the original 
+    // model does when it gives up after 200 tries.
+    if (prev_mov <= 5.5) {
+        float rnd = getRandomNormal(96, 28);
+        pres_angle += rnd - (rnd*prev_mov/5.5);
+    }
+    if (pres_angle >= 180) {
+        pres_angle = getRandomInt(0, 20) + 90;
     }
     
     pres_angle = pres_angle * sign;
     
-    // calculate move distance
-    pres_logmov = maxLogmov + 1;
-    while (pres_logmov > maxLogmov) {
-        pres_logmov = corrLogmov * prev_logmov + getRandomNormal(0.42, 0.48);
+    // calculate move distance, from a normal distribution truncated at maxLogmov
+    pres_logmov = getRandomTruncatedNormal(sim->porpoise.corrLogmov * prev_logmov + 0.42, 0.48, -INFINITY, sim->porpoise.maxLogmov);
+}
+
+GeometricWeights GeometricWeights::fit(const std::vector<float>& w, int window, float tolerance) {
+    GeometricWeights g;
+    g.window = std::min((int) w.size(), window);
+    if (g.window == 0) {
+        g.valid = true;
+        return g;
     }
-    pres_mov = pow(10, pres_logmov);
-    
-    // slow down if turning sharply
-    if (pres_mov > 10 && abs(pres_angle) > 90) {
-        pres_mov /= 5; 
-    } else if (pres_mov > 7 && abs(pres_angle) > 50) {
-        pres_mov /= 2;
+    for (int i = 0; i < g.window; ++i) {
+        if (w[i] <= 0) return g;
     }
     
-    float heading = Heading + pres_angle;
-    
-    if (heading < 0) {
-        heading += 360;
-    } else if (heading > 360) {
-        heading -= 360;
+    g.first = w[0];
+    g.ratio = g.window > 1 ? std::pow((double) w[g.window - 1] / w[0], 1.0 / (g.window - 1)) : 1.0;
+    double wi = g.first;
+    for (int i = 0; i < g.window; ++i, wi *= g.ratio) {
+        if (std::fabs(wi - w[i]) > tolerance * w[i]) return g;
     }
-    
-    // return unit vector
-    float x = sin(heading * PI/180);
-    float y = cos(heading * PI/180);
-    return Vector2df(x, y);
-    
+    g.last = g.first * std::pow(g.ratio, g.window - 1);
+    g.valid = true;
+    return g;
 }
+
+// Checks whether the memory weights decay geometrically. If they do, expected
+// energy and food attraction are kept as running sums, updated as the track 
+// changes, instead of being summed over the whole track every step.
+void PorpoiseParameters::setupMemory() {
+    const float tolerance = 1e-5; // about the precision of the weights as floats
+    work_mem_decay = GeometricWeights::fit(work_mem_strength, maxMemory, tolerance);
+    ref_mem_decay = GeometricWeights::fit(ref_mem_strength, maxMemory, tolerance);
+    ref_mem_reversed.assign(ref_mem_strength.rbegin(), ref_mem_strength.rend());
+    work_mem_reversed.assign(work_mem_strength.rbegin(), work_mem_strength.rend());
+}
+
 Vector2df Porpoise::calcFoodAttractionVector() {
+    const PorpoiseParameters& params = sim->porpoise;
     
     Vector2df attractionVector;
-    const int n = std::min(track.size(), ref_mem_strength.size());
-    
-    // calculate distances between current position and positions in recent past
-    for (int i = 1; i < n; ++i) { // start loop at 1 => no attraction to current pos
-        if (track[i].food == 0) continue; // if porpoise didn't find any food at this location, skip it
-        
-        Vector2df av = track[1].pos - currentPos; // vector pointing toward known food location
-        float attraction; // attraction strength
-        float length = av.length(); // distance to that location
-        
-        if (length < 0.001) {
-            length = 0.001;
-            attraction = 9999; // large attraction for close patches
-        } else {
-            attraction = track[i].food * ref_mem_strength[i] * (1/length);
+    const int n = std::min(track.size(), (int) params.ref_mem_strength.size());
+    if (n < 2) return attractionVector;
+    
+    // Attraction is summed over the remembered positions except the current one,
+    // skipping those where no food was found. Every term points from the current
+    // position to track[1], so the sum reduces to the weighted food found
+    // (and, for the case of very close patches, the number of positions with food)
+    // along that one direction.
+    float food = 0;
+    int nfood = 0;
+    if (params.ref_mem_decay.valid) {
+        // running sums, minus the current position
+        food = refMemorySum - params.ref_mem_decay.first * track.food(0);
+        nfood = foodMemories - (track.food(0) != 0);
+    } else {
+        // entries n-1 ... 1 of the track, against the matching (reversed) weights
+        const float* f = track.foods(n);
+        const float* w = params.ref_mem_reversed.data() + params.ref_mem_reversed.size() - n;
+        #pragma omp simd reduction(+:food, nfood)
+        for (int j = 0; j < n - 1; ++j) {
+            food += w[j] * f[j];
+            nfood += f[j] != 0;
         }
-        
-        // calculate unit vector
-        av *= (1/length);
+    }
+    if (nfood == 0) return attractionVector; // if porpoise didn't find any food, there is nothing to be attracted to
     
-        // multiply unit vector pointing to previous location by attraction score, 
-        // and add the result to the total attraction vector
-        attractionVector += av * attraction;
+    Vector2df av = track.pos(1) - currentPos; // vector pointing toward known food location
+    float length = av.length(); // distance to that location
+    
+    if (length < 0.001) {
+        // large attraction (9999) for each remembered patch, when patches are close
+        attractionVector = av * (1 / 0.001f) * (9999.0f * nfood);
+    } else {
+        // multiply unit vector pointing to previous location by attraction score
+        attractionVector = av * (1 / length) * (food / length);
     }
     
     return attractionVector;
@@ -294,8 +320,8 @@ Vector2df Porpoise::calcFoodAttractionVector() {
 
 void Porpoise::consumeFood() {
 
-    float& food = sim->Grid[currentCell].CurrentUtility; // current food level in patch
-    track.front().food = food; // porp remembers how much food it found here
+    float& food = sim->Grid[sim->water.rank(currentCell)].CurrentUtility; // current food level in patch
+    rememberFood(food); // porp remembers how much food it found here
 
     // only eat food if 1) there is food and 2) porp is not already at full energy
     if (food > 0 && EnergyLevel < 20) { 
@@ -313,27 +339,43 @@ void Porpoise::consumeFood() {
     }
 }
 
+void Porpoise::rememberFood(float food) {
+    const PorpoiseParameters& params = sim->porpoise;
+    float& remembered = track.food(0);
+    if (params.work_mem_decay.valid && params.work_mem_decay.window > 0) workMemorySum += params.work_mem_decay.first * (food - remembered);
+    if (params.ref_mem_decay.valid && params.ref_mem_decay.window > 0) refMemorySum += params.ref_mem_decay.first * (food - remembered);
+    if (std::min((int) params.ref_mem_strength.size(), params.maxMemory) > 0) foodMemories += (food != 0) - (remembered != 0);
+    remembered = food;
+}
+
 float Porpoise::calcExpectedEnergy() {
-    const int n = std::min(track.size(), work_mem_strength.size());
+    const PorpoiseParameters& params = sim->porpoise;
+    if (params.work_mem_decay.valid) return workMemorySum;
+    
+    // dot product of the n most recent food values with the matching weights
+    const int n = std::min(track.size(), (int) params.work_mem_strength.size());
+    const float* f = track.foods(n);
+    const float* w = params.work_mem_reversed.data() + params.work_mem_reversed.size() - n;
     float expectedEnergy{0};
-    for (int i = 0; i < n; i++) {
-        expectedEnergy += work_mem_strength[i] * track[i].food;
+    #pragma omp simd reduction(+:expectedEnergy)
+    for (int j = 0; j < n; j++) {
+        expectedEnergy += w[j] * f[j];
     }
     return expectedEnergy;
 }
 
 void Porpoise::setEnergyUse() {
-    E_use = monthlyEnergyMultiplier[sim->time->month()-1];
-    if (withCalf) E_use *= withCalfEnergyMultiplier;
+    E_use = sim->porpoise.monthlyEnergyMultiplier[sim->time->month()-1];
+    if (withCalf) E_use *= sim->porpoise.withCalfEnergyMultiplier;
 }
 
 void Porpoise::useEnergy() {
     // calculate expended energy this step and subtract that amount from the current energy level
     // total distance moved is the sum of prev_mov (food search) and dispersal
     float dist = prev_mov * 2.5; // seems to me this should be * 0.4, not * 2.5
-    if (dispersed) dist += meanDispersalDistance; // 
+    if (dispersed) dist += sim->porpoise.meanDispersalDistance; // 
     
-    float energyUsed = 0.001 * E_use * (stepEnergyMultiplier + dist * distEnergyMultiplier);
+    float energyUsed = 0.001 * E_use * (sim->porpoise.stepEnergyMultiplier + dist * sim->porpoise.distEnergyMultiplier);
     EnergyLevel -= energyUsed;
     cumulativeEnergy += EnergyLevel;
 }
@@ -342,10 +384,7 @@ bool Porpoise::checkEnergy() {
     bool survived = false;
     
     if (EnergyLevel > 0) { // porps with zero or negative energy die automatically (no need to check survival)
-        float yearly_survival = 1 - (m_mort_prob * exp(-EnergyLevel * x_surv_prob));
-        float step_survival = exp(log(yearly_survival) / 17520); // 17520 steps in a year
-        
-        if (getRandomFloat(0, 1) < step_survival) { // porp survives at current energy
+        if (getRandomFloat(0, 1) < sim->porpoise.stepSurvival(EnergyLevel)) { // porp survives at current energy
             survived = true;
         } else if (withCalf) { // porp survives by sacrificing calf
             abandonCalf();
@@ -356,6 +395,25 @@ bool Porpoise::checkEnergy() {
     return survived;
 }
 
+float PorpoiseParameters::calcStepSurvival(float energy) const {
+    float yearly_survival = 1 - (m_mort_prob * exp(-energy * x_surv_prob));
+    return exp(log(yearly_survival) / 17520); // 17520 steps in a year
+}
+
+// Step survival is tabulated by energy level for the survival parameters it
+// was built with. The table starts at energy 1: below that survival drops to
+// zero too steeply for linear interpolation, and it is calculated directly.
+void PorpoiseParameters::updateSurvivalTable() {
+    if (survivalTableParams[0] == m_mort_prob && survivalTableParams[1] == x_surv_prob) return;
+    survivalTable.build(1.0f, 20.0f, 4096, [this](float energy) { return calcStepSurvival(energy); });
+    survivalTableParams[0] = m_mort_prob;
+    survivalTableParams[1] = x_surv_prob;
+}
+
+float PorpoiseParameters::stepSurvival(float energy) const {
+    return survivalTable.covers(energy) ? survivalTable(energy) : calcStepSurvival(energy);
+}
+
 void Porpoise::calcDailyEnergy() {
     if (track.size() >= 48) {
         DailyEnergy.insert(DailyEnergy.begin(), cumulativeEnergy / 48.0f);
@@ -390,7 +448,7 @@ void Porpoise::considerDispersing() {
         
         // iterating from 0 to 8, not 0 to 9 (due to the comparison with i+1 inside the loop)
         //for (int i = 0; i < 9; ++i) {
-        for (int i = 0; i < dispersalInertia; ++i) {
+        for (int i = 0; i < sim->porpoise.dispersalInertia; ++i) {
             if (DailyEnergy[i] >= DailyEnergy[i+1]) {
                 return;
             }
@@ -420,11 +478,11 @@ void Porpoise::considerDispersing() {
                 Vector2df& xy = dailyPositions[7];
                 int cell = sim->cellFromPoint(xy);
                 if (cell != -1) {
-                    int block = sim->Grid[cell].Block;
+                    int block = sim->landscape.block(cell);
                     float dist = currentPos.distanceFrom(xy);
                     movementMode = returningDispersal;
                     dispersalTarget.set(block, xy, dist);
-                    //Logger::debug(0, "porp %d is returning to area visited 7 days ago (%.02f, %.02f", Id, xy.x, xy.y);
+                    //sim->debug(0, "porp %d is returning to area visited 7 days ago (%.02f, %.02f", Id, xy.x, xy.y);
                 }
             }
         }
@@ -436,8 +494,7 @@ void Porpoise::pickDispersalTarget(int excludeBlock) {
     int currentBlock = -1;
 
     if (currentCell != -1) {
-        currentBlock = sim->Grid[currentCell].Block;
-        //currentAbundanceBlock = sim->Grid[currentCell].abundanceBlock;
+        currentBlock = sim->landscape.block(currentCell);
     } 
     
     std::vector<dispersalCandidate> blocks;
@@ -449,7 +506,7 @@ void Porpoise::pickDispersalTarget(int excludeBlock) {
     for (auto& block : sim->Blocks) {
         if (block.id() == currentBlock) continue; // skip current block
         float distSquared = currentPos.distanceFromSquared(block.center()); // in map units
-        if (distSquared > minDispersalDistanceSquared && distSquared < maxDispersalDistanceSquared && (excludeBlock == -1 || block.id() != excludeBlock)) {
+        if (distSquared > sim->porpoise.minDispersalDistanceSquared && distSquared < sim->porpoise.maxDispersalDistanceSquared && (excludeBlock == -1 || block.id() != excludeBlock)) {
             float distEstimate = distSquared * (1.0f / sqrt(distSquared));
             blocks.emplace_back(block.id(), 
                                 distEstimate,
@@ -473,7 +530,7 @@ void Porpoise::pickDispersalTarget(int excludeBlock) {
     Vector2df target = sim->Blocks[block.id].center();
     dispersalTarget.set(block.id, target, block.distance);
 
-    //Logger::debug(0, "porp %d is dispering towards block %d (distance = %f, value = %.10g, best = %.10g, worst = %.10g, energy = %.3f)", 
+    //sim->debug(0, "porp %d is dispering towards block %d (distance = %f, value = %.10g, best = %.10g, worst = %.10g, energy = %.3f)", 
     //    Id, block.id, block.distance, block.value, blocks[0].value, blocks[12].value, EnergyLevel);
     //}
 
@@ -489,16 +546,16 @@ void Porpoise::disperseTowardsTarget() {
 
     if (dispersalStepCounter > 48 && currentPos.distanceFrom(dailyPositions[1]) < 2) { // porp has moved less than 0.8 km since yesterday 
         stop = true;
-        //Logger::debug(0, "porp %d switched to coastal dispersal (moved less than 0.8 km in last 24 h)", Id);
+        //sim->debug(0, "porp %d switched to coastal dispersal (moved less than 0.8 km in last 24 h)", Id);
     } else if (dispersalStepCounter > 432 &&currentPos.distanceFrom(dailyPositions[8]) < 6) { // porp has moved less than 2.4 km in the last week
         stop = true;
-        //Logger::debug(0, "porp %d switched to coastal dispersal (moved less than 2.4 km since last week)", Id);
+        //sim->debug(0, "porp %d switched to coastal dispersal (moved less than 2.4 km since last week)", Id);
     } else if (currentDist < 50) {   // porp has crossed into target block
         stop = true;
-        //Logger::debug(0, "porp %d arrived in its destination block!", Id);
+        //sim->debug(0, "porp %d arrived in its destination block!", Id);
     //} else if (currentCell != -1 && sim->Grid[cell].DistanceToCoast < minDispersalDistanceToLand) { // porp is moving too close to land
     //    stop = true;
-    //    Logger::debug(0, "porp %d switched to coastal dispersal (moving too close to land)", Id);
+    //    sim->debug(0, "porp %d switched to coastal dispersal (moving too close to land)", Id);
     }
     
     if (stop) {
@@ -509,7 +566,7 @@ void Porpoise::disperseTowardsTarget() {
     }
     
     Vector2df dispStep = dispersalTarget.pos() - currentPos; // vector to destination (total delta in x and y coordinates)
-    Vector2df mov = dispStep.normalize() * meanDispersalDistance; // rescale vector length to average dispersal distance
+    Vector2df mov = dispStep.normalize() * sim->porpoise.meanDispersalDistance; // rescale vector length to average dispersal distance
 
     // adjust dispersal direction by up to 30 degrees to swim towards deeper waters 
     // look 8 cells (2.4 km) ahead to make sure there is enough water 
@@ -543,7 +600,7 @@ void Porpoise::disperseAlongCoast() {
     if (movementMode == normalMove) return;
     
     // vector pointing away from place visited 1 day ago
-    Vector2df mov = (currentPos - dailyPositions[1]).normalize() * meanDispersalDistance; 
+    Vector2df mov = (currentPos - dailyPositions[1]).normalize() * sim->porpoise.meanDispersalDistance; 
     
     // turn up to 80 degres in either direction (preferring smaller angles) to find a path
     // between 1 km (2.5 cells) and 4 km (10 cells) from the coast
@@ -554,7 +611,7 @@ void Porpoise::disperseAlongCoast() {
     
     // check that the elected path is actually traversable, and if it's not, stop dispersing
     if (!sim->IsPathTraversable(currentPos.x, currentPos.y, newPos.x, newPos.y)) {
-        //Logger::debug(0, "porp %d stopped coastal dispersal, because it couldn't find a traversable path (current pos = %.02f, %.02f)", Id, X[0], Y[0]);
+        //sim->debug(0, "porp %d stopped coastal dispersal, because it couldn't find a traversable path (current pos = %.02f, %.02f)", Id, X[0], Y[0]);
         movementMode = normalMove;
         return;
     }
@@ -581,14 +638,39 @@ void Porpoise::disperseAlongCoast() {
  ***********************************************************************************************/
 
 
-void Porpoise::setMatingDay() {
+// schedules an event on the next occurrence of day yday of the year, today included.
+// Days outside 1-365 never occur.
+void Porpoise::scheduleEvent(int event, int yday) {
+    if (yday < 1 || yday > EventCalendar::daysPerYear) return;
+    int year = sim->time->year();
+    if (yday < sim->time->yday()) ++year;
+    sim->calendar.schedule(this, event, EventCalendar::dayNumber(year, yday));
+}
+
+// Age grows by dailyAging in the first pass of each day, so max_age is reached
+// after about (max_age - Age) / dailyAging days. The sum of floats can round
+// either way, so the check is scheduled two days early and then repeated daily.
+void Porpoise::scheduleAgeOut(int today) {
+    int days = (sim->porpoise.max_age - Age) / dailyAging - 2;
+    ageOutDay = today + std::max(0, days);
+    sim->ageOuts.schedule(this, EventCalendar::ageOut, ageOutDay);
+}
+
+// draws the mating day of this year (or the next, once this year's has passed)
+void Porpoise::setMatingDay(bool nextYear) {
     this->matingDay = sanitizeDayNumber(round(getRandomNormal(225, 20)));
+    if (nextYear) {
+        sim->calendar.schedule(this, EventCalendar::mating, EventCalendar::dayNumber(sim->time->year() + 1, matingDay));
+    } else {
+        scheduleEvent(EventCalendar::mating, matingDay);
+    }
 }
 
 void Porpoise::Mate() {
-    if (Age >= AgeOfMaturity && isPregnant == false && getRandomFloat(0, 1) < pregnancy_prob) {
+    if (Age >= sim->porpoise.AgeOfMaturity && isPregnant == false && getRandomFloat(0, 1) < sim->porpoise.pregnancy_prob) {
         isPregnant = true;
         calfBirthday = sanitizeDayNumber(sim->time->yday() - 65); // 10 months pregnancy (wrapping around the year)
+        scheduleEvent(EventCalendar::birth, calfBirthday);
     }
 }
 
@@ -596,6 +678,7 @@ void Porpoise::giveBirth() {
     isPregnant = false;
     withCalf = true;
     weaningDay = sanitizeDayNumber(sim->time->yday() + 240); // nursing for 8 months
+    scheduleEvent(EventCalendar::weaning, weaningDay);
     calfBirthday = { -1 };
     setEnergyUse();
 }
@@ -603,13 +686,15 @@ void Porpoise::giveBirth() {
 void Porpoise::weanCalf() {
     // create a new calf, and set its position to the same as its mother
     auto calf = std::unique_ptr<Porpoise>(new Porpoise(*this)); 
-    Porpoises.push_back(std::move(calf));
+    add(*sim, std::move(calf));
     withCalf = { false };
     weaningDay = { -1 };
     setEnergyUse();
 }
 
 void Porpoise::abandonCalf() {
+    #pragma omp critical (calendar)
+    sim->calendar.cancel(this, EventCalendar::weaning, weaningDay);
     withCalf = { false }; 
     weaningDay = { -1 };
     setEnergyUse();
@@ -627,19 +712,64 @@ void Porpoise::abandonCalf() {
 bool Porpoise::Entangled() {
     
     // list of gillnets in current cell
-    auto& gillnets = sim->Grid[currentCell].gillnets;
+    auto& gillnets = sim->Grid[sim->water.rank(currentCell)].gillnets;
     
     if (gillnets.size() == 0) {
         return false;
     }
     // check if the travelled path intersects with any gillnets
     for (Gillnet* gillnet : gillnets) {
-        if (gillnet->check4(currentPos, currentCell)) {
-            int currentBlock = sim->Grid[currentCell].fisheryBlock;
-            sim->logger->log(sim->time->year(), sim->time->month(), sim->time->day(), currentBlock, gillnet->type(), 1, currentPos.x, currentPos.y);
+        if (Entangled(gillnet)) {
             return true;
         }
     }
     
     return false;
 }
+
+// check for entanglement in one specific gillnet, and record the bycatch if it happens
+bool Porpoise::Entangled(Gillnet* gillnet) {
+    if (gillnet->check4(currentPos, currentCell)) {
+        int currentBlock = sim->landscape.fisheryRegion(currentCell);
+        sim->logger->log(sim->time->year(), sim->time->month(), sim->time->day(), currentBlock, gillnet->type(), 1, currentPos.x, currentPos.y);
+        return true;
+    }
+    return false;
+}
+
+/***********************************************************************************************
+ * 
+ * 
+ *                                   POPULATION COUNTERS
+ * 
+ * 
+ ***********************************************************************************************/
+
+// adds the porpoise to the population counters
+void Porpoise::count() {
+    counted = true;
+    updateCounters();
+}
+
+void Porpoise::uncount() {
+    if (!counted) return;
+    sim->counters.move(countedRegion, countedBlock, countedAgeClass, -1, -1, -1);
+    countedRegion = countedBlock = countedAgeClass = -1;
+    counted = false;
+}
+
+// moves the porpoise in the population counters, if its region, block or age class has changed
+void Porpoise::updateCounters() {
+    if (!counted) return;
+    int newRegion = -1, newBlock = -1;
+    if (currentCell != -1) {
+        newRegion = sim->landscape.abundanceRegion(currentCell);
+        newBlock = sim->landscape.block(currentCell);
+    }
+    int newAgeClass = ageClassOf(Age);
+    if (newRegion == countedRegion && newBlock == countedBlock && newAgeClass == countedAgeClass) return;
+    sim->counters.move(countedRegion, countedBlock, countedAgeClass, newRegion, newBlock, newAgeClass);
+    countedRegion = newRegion;
+    countedBlock = newBlock;
+    countedAgeClass = newAgeClass;
+}
@@ -2,30 +2,19 @@
 #define __PORPOISE__
 #include <algorithm>
 #include <iostream>
+#include <memory>
 #include "Settings.hpp"
 #include "Vector2d.hpp"
 #include "Gillnet.h"
 #include "Block.hpp"
 #include "Position.hpp"
-
-extern int DEBUG_LEVEL;
+#include "Track.hpp"
+#include "EventCalendar.hpp"
 
 class Settings;
 class Gillnet;
 
-struct PorpoiseState {
-    Vector2df pos;
-    float food;
-    PorpoiseState() : pos(0, 0), food(0) {};
-    PorpoiseState(Vector2df pos) : pos(pos), food(0) {};
-    PorpoiseState(Vector2df pos, float food) : pos(pos), food(food) {};
-};
-
 class Porpoise {
-private:
-    static int nextId;
-    static Settings* sim;
-    friend class Settings;
 public:
     enum PorpoiseMovementMode {
         normalMove = 0,
@@ -33,45 +22,25 @@ public:
         coastalDispersal = 2,
         returningDispersal = 3
     };
-    // static parameters, apply to all porps
-    static std::vector<std::unique_ptr<Porpoise>> Porpoises;
-    static float AgeOfMaturity;
-    static float monthlyEnergyMultiplier[12];
-    static float withCalfEnergyMultiplier;
-    static float distEnergyMultiplier;
-    static float stepEnergyMultiplier;
-    static float m_mort_prob;
-    static float x_surv_prob;
-    static int dispersalInertia;
-    static float meanDispersalDistance;
-    static float minDispersalDistance;
-    static float maxDispersalDistance;
-    static float minDispersalDistanceSquared;
-    static float maxDispersalDistanceSquared;
-    static float minDispersalDepth;
-    static float minDispersalDistanceToLand;
-    static float pregnancy_prob;
-    static float max_age;
-    static int maxMemory;
-    static float inertia_const;
-    static float corrLogmov;
-    static float corrAngle;
-    static float m;
-    static float maxLogmov;
-    static std::vector<int> age_dist;
-    static std::vector<float> ref_mem_strength; // reference memory decay rate: determines how fast animals forget the location of previously visited food patches
-    static std::vector<float> work_mem_strength; // satiation memory decay rate; determines how fast the animals get hungry after eating
-    static void resetId() { nextId = 0; } 
-    static std::shared_ptr<Settings> Config;
+    static constexpr float dailyAging = 0.002739726f; // 1/365 years
+    static void add(Settings& sim, std::unique_ptr<Porpoise> porp); // appends porp to the porpoises of sim
+    static void remove(Settings& sim, std::vector<int>& indices); // removes the porpoises of sim at indices (reordering both)
+    static int ageClassOf(float age) { return age >= 10 ? 2 : age >= 4 ? 1 : 0; } // juvenile, adult, old
     
     // individual porp properties
 
+    Settings* sim; // the simulation the porpoise lives in
     int Id; // incremented automatically
-    float Age = getRandomDiscrete(&age_dist); // age in decimal years, incremented daily by 1/365
+    int index { -1 }; // position in sim->Porpoises, kept by add() and remove()
+    float Age = 0; // age in decimal years, incremented daily by 1/365 (drawn from age_dist, or 8 months for weaned calves)
     float Heading = getRandomFloat(0.0f, 359.9f); // randomly pick an initial direction (0 is north)
     int currentCell{ -1 };
     Vector2df currentPos{}, lastPos{};
-    std::vector<PorpoiseState> track;
+    Track track;
+    // running sums over the track, kept for geometric memory weights
+    double workMemorySum = 0; // sum of work_mem_strength[i] * track[i].food
+    double refMemorySum = 0; // sum of ref_mem_strength[i] * track[i].food
+    int foodMemories = 0; // number of positions within reach of ref_mem_strength where food was found
     std::vector<Vector2df> dailyPositions = std::vector<Vector2df>(10);
     
     bool isPregnant = false; // true for pregnant, false otherwise
@@ -79,6 +48,11 @@ public:
     int matingDay = { -1 }; // mating day
     int calfBirthday = { -1 }; // calf due day (if pregnant)
     int weaningDay = { -1 }; // calf weaning day (if with calf)
+    int ageOutDay = { -1 }; // day number of the next check against max_age (see EventCalendar)
+    
+    // where the porpoise is counted in sim->counters (-1 if not counted)
+    int countedRegion { -1 }, countedBlock { -1 }, countedAgeClass { -1 };
+    bool counted { false };
     
     float EnergyLevel = getRandomNormal(10, 1); // 0 - 20
     float cumulativeEnergy = 0;
@@ -96,13 +70,15 @@ public:
     float pres_mov, pres_logmov, pres_angle, CRW_contrib{ -9999 };
     
     // functions    
-    Porpoise(int SurveyBlock); // constructor for initial population of porpoises (calves and non-calves)
+    Porpoise(Settings* sim, int SurveyBlock); // constructor for initial population of porpoises (calves and non-calves)
     Porpoise(const Porpoise& mother); // constructor for calves that are born as the sim progresses
+    ~Porpoise(); // cancels the porpoise's scheduled events
 
     Vector2df calcFoodAttractionVector();
-    Vector2df calcCRW();
+    void drawCRW();
     float calcExpectedEnergy();
     void consumeFood();
+    void rememberFood(float food);
     void setEnergyUse();
     void useEnergy();
     bool checkEnergy();
@@ -113,13 +89,20 @@ public:
     void disperseTowardsTarget();
     void disperseAlongCoast();
     void intrinsicMove();
+    void finishIntrinsicMove(Vector2df newPos);
     void executeMove(Vector2df newPos, float newHeading, PorpoiseMovementMode mode);
-    void setMatingDay();
+    void setMatingDay(bool nextYear = false);
+    void scheduleEvent(int event, int yday);
+    void scheduleAgeOut(int today);
     bool Entangled();
+    bool Entangled(Gillnet* gillnet);
     void Mate();
     void giveBirth();
     void weanCalf();
     void setHeading(float newHeading);
+    void count();
+    void uncount();
+    void updateCounters();
 };
 
 #endif // __PORPOISE__
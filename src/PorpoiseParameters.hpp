@@ -0,0 +1,62 @@
+#ifndef __PORPOISEPARAMETERS__
+#define __PORPOISEPARAMETERS__
+#include <vector>
+#include "FastMath.hpp"
+
+// Memory weights that decay geometrically, w_i = first * ratio^i, over the
+// first `window` remembered positions. Sums weighted this way can be updated
+// incrementally as positions are added to the track (see PorpoiseParameters::setupMemory).
+struct GeometricWeights {
+    bool valid { false };
+    int window { 0 };
+    double first { 0 }, ratio { 0 }, last { 0 }; // w_0, w_{i+1}/w_i, w_{window-1}
+
+    // fits the weights, and checks that none deviates more than tolerance (relative) from the fit
+    static GeometricWeights fit(const std::vector<float>& w, int window, float tolerance);
+};
+
+/*
+ * The parameters of the porpoises of one simulation, set from the configuration
+ * of the run (see Settings::configure), with the tables derived from them.
+ */
+struct PorpoiseParameters {
+    float AgeOfMaturity;
+    float monthlyEnergyMultiplier[12];
+    float withCalfEnergyMultiplier;
+    float distEnergyMultiplier;
+    float stepEnergyMultiplier;
+    float m_mort_prob;
+    float x_surv_prob;
+    int dispersalInertia;
+    float meanDispersalDistance;
+    float minDispersalDistance;
+    float maxDispersalDistance;
+    float minDispersalDistanceSquared;
+    float maxDispersalDistanceSquared;
+    float minDispersalDepth;
+    float minDispersalDistanceToLand;
+    float pregnancy_prob;
+    float max_age;
+    int maxMemory;
+    float inertia_const;
+    float corrLogmov;
+    float corrAngle;
+    float m;
+    float maxLogmov;
+    std::vector<int> age_dist;
+    std::vector<float> ref_mem_strength; // reference memory decay rate: determines how fast animals forget the location of previously visited food patches
+    std::vector<float> work_mem_strength; // satiation memory decay rate; determines how fast the animals get hungry after eating
+    GeometricWeights ref_mem_decay, work_mem_decay; // valid if the memory weights above are geometric
+    std::vector<float> ref_mem_reversed, work_mem_reversed; // the memory weights, last first (to match the track's layout)
+
+    void setupMemory();
+    float calcStepSurvival(float energy) const;
+    float stepSurvival(float energy) const;
+    void updateSurvivalTable(); // rebuilds the step survival table if m_mort_prob or x_surv_prob changed
+
+private:
+    LookupTable survivalTable;
+    float survivalTableParams[2] = { -1, -1 };
+};
+
+#endif // __PORPOISEPARAMETERS__
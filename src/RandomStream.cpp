@@ -0,0 +1,127 @@
+#include <cmath>
+#include <algorithm>
+#include "RandomStream.hpp"
+#include <random>
+#include "omp.h"
+
+namespace {
+
+// Ziggurat tables for the standard normal, 128 layers (Marsaglia & Tsang 2000).
+// Scaled for a signed 24-bit draw, so that the layer index can be taken from
+// bits that are not part of the value.
+struct ZigguratTables {
+    uint32_t kn[128];
+    float wn[128], fn[128];
+    
+    ZigguratTables() {
+        const double m1 = 8388608.0; // 2^23
+        const double vn = 9.91256303526217e-3;
+        double dn = 3.442619855899, tn = dn;
+        double q = vn / exp(-0.5 * dn * dn);
+        
+        kn[0] = (uint32_t) ((dn / q) * m1);
+        kn[1] = 0;
+        wn[0] = q / m1;
+        wn[127] = dn / m1;
+        fn[0] = 1.0f;
+        fn[127] = exp(-0.5 * dn * dn);
+        for (int i = 126; i >= 1; --i) {
+            dn = sqrt(-2 * log(vn / dn + exp(-0.5 * dn * dn)));
+            kn[i + 1] = (uint32_t) ((dn / tn) * m1);
+            tn = dn;
+            fn[i] = exp(-0.5 * dn * dn);
+            wn[i] = dn / m1;
+        }
+    }
+};
+
+const ZigguratTables zig;
+const float zigR = 3.442620f; // start of the tail
+
+thread_local RandomStream* boundStream = nullptr;
+
+} // namespace
+
+void RandomStream::seed(uint64_t seed, uint64_t stream) {
+    m_engine.seed(seed, stream);
+    m_nextBits = bufferSize;
+    m_nextNormal = bufferSize;
+}
+
+void RandomStream::refillBits() {
+    for (int i = 0; i < bufferSize; ++i) {
+        m_bits[i] = m_engine();
+    }
+    m_nextBits = 0;
+}
+
+void RandomStream::refillNormals() {
+    for (int i = 0; i < bufferSize; ++i) {
+        m_normals[i] = ziggurat();
+    }
+    m_nextNormal = 0;
+}
+
+float RandomStream::ziggurat() {
+    for (;;) {
+        uint32_t u = bits();
+        int32_t hz = (int32_t) u >> 8; // value: top 24 bits, signed
+        int iz = u & 127; // layer: bottom 7 bits
+        uint32_t absHz = hz < 0 ? 0u - (uint32_t) hz : (uint32_t) hz;
+        float x = hz * zig.wn[iz];
+        
+        // inside the layer's rectangle: accept (the common case)
+        if (absHz < zig.kn[iz]) return x;
+        
+        if (iz == 0) {
+            // base layer: sample from the tail beyond zigR
+            float y;
+            do {
+                x = -logf(uniformOpen()) / zigR;
+                y = -logf(uniformOpen());
+            } while (y + y < x * x);
+            return hz > 0 ? zigR + x : -zigR - x;
+        }
+        
+        // wedge between the rectangle and the density
+        if (zig.fn[iz] + uniform() * (zig.fn[iz - 1] - zig.fn[iz]) < expf(-0.5f * x * x)) return x;
+    }
+}
+
+RandomStreams::~RandomStreams() {
+    unbind();
+}
+
+void RandomStreams::seed(int nThread) {
+    std::random_device device;
+    uint64_t seed = ((uint64_t) device() << 32) | device();
+    m_streams.resize(std::max(1, nThread));
+    for (size_t t = 0; t < m_streams.size(); ++t) {
+        m_streams[t].seed(seed, t);
+    }
+}
+
+void RandomStreams::bind() {
+    boundStream = &m_streams[omp_get_thread_num() % m_streams.size()];
+}
+
+void RandomStreams::unbind() {
+    if (!m_streams.empty() && boundStream >= m_streams.data() && boundStream < m_streams.data() + m_streams.size()) {
+        boundStream = nullptr;
+    }
+}
+
+RandomStream& threadRng() {
+    if (!boundStream) {
+        // draws outside any simulation come from a stream of the thread's own
+        thread_local RandomStream own;
+        thread_local bool seeded = false;
+        if (!seeded) {
+            std::random_device device;
+            own.seed(((uint64_t) device() << 32) | device(), omp_get_thread_num());
+            seeded = true;
+        }
+        return own;
+    }
+    return *boundStream;
+}
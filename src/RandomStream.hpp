@@ -0,0 +1,98 @@
+#ifndef __RANDOMSTREAM__
+#define __RANDOMSTREAM__
+#include <cstdint>
+#include <vector>
+#include "pcg_random.hpp"
+
+/*
+ * Random variates for the hot paths. Every OpenMP thread of a simulation draws
+ * from its own stream (a pcg32 engine on its own sequence), so threads neither
+ * share nor race on engine state. Raw 32-bit outputs and standard normals are generated
+ * in bulk into per-stream buffers and handed out one at a time.
+ *
+ * Uniforms are made from the bits directly (the top 24 bits scaled to [0, 1)),
+ * integers with Lemire's multiply-and-shift method, and normals with the
+ * Marsaglia-Tsang ziggurat, which needs a single 32-bit draw for ~99% of values.
+ */
+class RandomStream {
+public:
+    static const int bufferSize = 256;
+
+private:
+    pcg32 m_engine;
+    uint32_t m_bits[bufferSize];
+    float m_normals[bufferSize];
+    int m_nextBits { bufferSize };
+    int m_nextNormal { bufferSize };
+
+    void refillBits();
+    void refillNormals();
+    float ziggurat();
+
+public:
+    typedef uint32_t result_type; // for use with std::shuffle and the like
+    static constexpr uint32_t min() { return 0; }
+    static constexpr uint32_t max() { return UINT32_MAX; }
+    uint32_t operator()() { return bits(); }
+
+    void seed(uint64_t seed, uint64_t stream);
+
+    uint32_t bits() {
+        if (m_nextBits == bufferSize) refillBits();
+        return m_bits[m_nextBits++];
+    }
+    // uniform on [0, 1)
+    float uniform() {
+        return (bits() >> 8) * (1.0f / 16777216.0f);
+    }
+    // uniform on (0, 1), with 53 bits of resolution
+    double uniformOpen() {
+        uint64_t a = bits() >> 5, b = bits() >> 6;
+        return (a * 67108864.0 + b + 0.5) * (1.0 / 9007199254740992.0);
+    }
+    // uniform integer on [min, max]
+    int integer(int min, int max) {
+        uint32_t range = (uint32_t) (max - min) + 1;
+        if (range == 0) return (int) bits(); // the full 32-bit range
+        uint64_t m = (uint64_t) bits() * range;
+        uint32_t low = (uint32_t) m;
+        if (low < range) {
+            uint32_t threshold = -range % range;
+            while (low < threshold) {
+                m = (uint64_t) bits() * range;
+                low = (uint32_t) m;
+            }
+        }
+        return min + (int) (m >> 32);
+    }
+    // standard normal
+    float normal() {
+        if (m_nextNormal == bufferSize) refillNormals();
+        return m_normals[m_nextNormal++];
+    }
+};
+
+/*
+ * The streams of one simulation, one per thread of the team running it. A thread
+ * draws from the stream it was last bound to, so each thread binds itself to
+ * the streams of its simulation before drawing (see do_sim), and simulations
+ * running side by side never share a stream.
+ */
+class RandomStreams {
+private:
+    std::vector<RandomStream> m_streams;
+public:
+    RandomStreams() = default;
+    RandomStreams(const RandomStreams&) = delete;
+    RandomStreams& operator=(const RandomStreams&) = delete;
+    ~RandomStreams(); // unbinds the calling thread, if bound to these streams
+
+    void seed(int nThread); // (re)seeds nThread streams, from the system's random device
+    void bind(); // the calling thread draws from the stream of its thread number
+    void unbind(); // the calling thread no longer draws from these streams, if it did
+};
+
+// the stream the calling thread is bound to
+RandomStream& threadRng();
+
+#endif // __RANDOMSTREAM__
@@ -10,6 +10,79 @@ Rcpp::Rostream<true>&  Rcpp::Rcout = Rcpp::Rcpp_cout_get();
 Rcpp::Rostream<false>& Rcpp::Rcerr = Rcpp::Rcpp_cerr_get();
 #endif
 
+// validate_fastmath
+Rcpp::DataFrame validate_fastmath(double mMortProb, double xSurvProb);
+RcppExport SEXP _posim_validate_fastmath(SEXP mMortProbSEXP, SEXP xSurvProbSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< double >::type mMortProb(mMortProbSEXP);
+    Rcpp::traits::input_parameter< double >::type xSurvProb(xSurvProbSEXP);
+    rcpp_result_gen = Rcpp::wrap(validate_fastmath(mMortProb, xSurvProb));
+    return rcpp_result_gen;
+END_RCPP
+}
+// sasc_to_binary
+void sasc_to_binary(std::string sasc, std::string filename, bool compress);
+RcppExport SEXP _posim_sasc_to_binary(SEXP sascSEXP, SEXP filenameSEXP, SEXP compressSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type sasc(sascSEXP);
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< bool >::type compress(compressSEXP);
+    sasc_to_binary(sasc, filename, compress);
+    return R_NilValue;
+END_RCPP
+}
+// write_binary_sasc
+void write_binary_sasc(std::string filename, Rcpp::NumericVector header, Rcpp::List columns, bool compress);
+RcppExport SEXP _posim_write_binary_sasc(SEXP filenameSEXP, SEXP headerSEXP, SEXP columnsSEXP, SEXP compressSEXP) {
+BEGIN_RCPP
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    Rcpp::traits::input_parameter< Rcpp::NumericVector >::type header(headerSEXP);
+    Rcpp::traits::input_parameter< Rcpp::List >::type columns(columnsSEXP);
+    Rcpp::traits::input_parameter< bool >::type compress(compressSEXP);
+    write_binary_sasc(filename, header, columns, compress);
+    return R_NilValue;
+END_RCPP
+}
+// read_binary_sasc
+Rcpp::List read_binary_sasc(std::string filename);
+RcppExport SEXP _posim_read_binary_sasc(SEXP filenameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_binary_sasc(filename));
+    return rcpp_result_gen;
+END_RCPP
+}
+// read_binary_sasc_header
+Rcpp::NumericVector read_binary_sasc_header(std::string filename);
+RcppExport SEXP _posim_read_binary_sasc_header(SEXP filenameSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< std::string >::type filename(filenameSEXP);
+    rcpp_result_gen = Rcpp::wrap(read_binary_sasc_header(filename));
+    return rcpp_result_gen;
+END_RCPP
+}
+// benchmark_paths
+Rcpp::DataFrame benchmark_paths(SEXP landscape, int n, double maxDistance, int seed);
+RcppExport SEXP _posim_benchmark_paths(SEXP landscapeSEXP, SEXP nSEXP, SEXP maxDistanceSEXP, SEXP seedSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< SEXP >::type landscape(landscapeSEXP);
+    Rcpp::traits::input_parameter< int >::type n(nSEXP);
+    Rcpp::traits::input_parameter< double >::type maxDistance(maxDistanceSEXP);
+    Rcpp::traits::input_parameter< int >::type seed(seedSEXP);
+    rcpp_result_gen = Rcpp::wrap(benchmark_paths(landscape, n, maxDistance, seed));
+    return rcpp_result_gen;
+END_RCPP
+}
 // do_sim
 Rcpp::RObject do_sim(Rcpp::List& RSim);
 RcppExport SEXP _posim_do_sim(SEXP RSimSEXP) {
@@ -21,6 +94,17 @@ BEGIN_RCPP
     return rcpp_result_gen;
 END_RCPP
 }
+// new_landscape
+SEXP new_landscape(Rcpp::List conf);
+RcppExport SEXP _posim_new_landscape(SEXP confSEXP) {
+BEGIN_RCPP
+    Rcpp::RObject rcpp_result_gen;
+    Rcpp::RNGScope rcpp_rngScope_gen;
+    Rcpp::traits::input_parameter< Rcpp::List >::type conf(confSEXP);
+    rcpp_result_gen = Rcpp::wrap(new_landscape(conf));
+    return rcpp_result_gen;
+END_RCPP
+}
 // start_profiler
 SEXP start_profiler(SEXP str);
 RcppExport SEXP _posim_start_profiler(SEXP strSEXP) {
@@ -44,7 +128,14 @@ END_RCPP
 }
 
 static const R_CallMethodDef CallEntries[] = {
+    {"_posim_validate_fastmath", (DL_FUNC) &_posim_validate_fastmath, 2},
+    {"_posim_sasc_to_binary", (DL_FUNC) &_posim_sasc_to_binary, 3},
+    {"_posim_write_binary_sasc", (DL_FUNC) &_posim_write_binary_sasc, 4},
+    {"_posim_read_binary_sasc", (DL_FUNC) &_posim_read_binary_sasc, 1},
+    {"_posim_read_binary_sasc_header", (DL_FUNC) &_posim_read_binary_sasc_header, 1},
+    {"_posim_benchmark_paths", (DL_FUNC) &_posim_benchmark_paths, 4},
     {"_posim_do_sim", (DL_FUNC) &_posim_do_sim, 1},
+    {"_posim_new_landscape", (DL_FUNC) &_posim_new_landscape, 1},
     {"_posim_start_profiler", (DL_FUNC) &_posim_start_profiler, 1},
     {"_posim_stop_profiler", (DL_FUNC) &_posim_stop_profiler, 0},
     {NULL, NULL, 0}
@@ -0,0 +1,68 @@
+#include <cmath>
+#include "Samplers.hpp"
+#include "RandomStream.hpp"
+
+double normalCdf(double x) {
+    return 0.5 * std::erfc(-x * M_SQRT1_2);
+}
+
+// Acklam's rational approximation (relative error < 1.15e-9), polished by one
+// step of Halley's method against the exact CDF.
+double normalQuantile(double p) {
+    static const double a[] = { -3.969683028665376e+01, 2.209460984245205e+02, -2.759285104469687e+02,
+                                 1.383577518672690e+02, -3.066479806614716e+01, 2.506628277459239e+00 };
+    static const double b[] = { -5.447609879822406e+01, 1.615858368580409e+02, -1.556989798598866e+02,
+                                 6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                -2.549732539343734e+00, 4.374664141464968e+00, 2.938163982698783e+00 };
+    static const double d[] = { 7.784695709041462e-03, 3.224671290700398e-01, 2.445134137142996e+00,
+                                3.754408661907416e+00 };
+    const double plow = 0.02425;
+    
+    if (p <= 0) return -INFINITY;
+    if (p >= 1) return INFINITY;
+    
+    double x;
+    if (p < plow) {
+        double q = sqrt(-2 * log(p));
+        x = (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+            ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    } else if (p <= 1 - plow) {
+        double q = p - 0.5;
+        double r = q * q;
+        x = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5])*q /
+            (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1);
+    } else {
+        double q = sqrt(-2 * log1p(-p));
+        x = -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+             ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1);
+    }
+    
+    double e = normalCdf(x) - p;
+    double u = e * sqrt(2 * M_PI) * exp(x * x / 2);
+    return x - u / (1 + x * u / 2);
+}
+
+float getRandomTruncatedNormal(float mean, float sd, float lower, float upper) {
+    double a = (lower - mean) / sd;
+    double b = (upper - mean) / sd;
+    
+    // work in the lower tail, where the CDF keeps its precision
+    bool mirror = a > 0;
+    if (mirror) {
+        double tmp = a;
+        a = -b;
+        b = -tmp;
+    }
+    
+    double pa = normalCdf(a);
+    double pb = normalCdf(b);
+    double p = pa + (pb - pa) * threadRng().uniformOpen();
+    double z = normalQuantile(p);
+    
+    // guard against rounding just outside the bounds
+    if (z < a) z = a;
+    if (z > b) z = b;
+    if (mirror) z = -z;
+    return mean + sd * z;
+}
@@ -0,0 +1,19 @@
+#ifndef __SAMPLERS__
+#define __SAMPLERS__
+
+/*
+ * Samplers for truncated distributions. Instead of drawing until a value falls
+ * within bounds, values are drawn directly from the truncated distribution by
+ * inversion: a uniform variate is drawn between the CDF values of the bounds
+ * and mapped back through the quantile function. Each draw costs one uniform
+ * variate, however narrow the interval.
+ */
+
+// standard normal CDF and quantile function
+double normalCdf(double x);
+double normalQuantile(double p);
+
+// N(mean, sd) truncated to [lower, upper]. Either bound may be infinite.
+float getRandomTruncatedNormal(float mean, float sd, float lower, float upper);
+
+#endif // __SAMPLERS__
@@ -0,0 +1,79 @@
+#ifndef __SCHEDULER__
+#define __SCHEDULER__
+#include <vector>
+#include <algorithm>
+#include "omp.h"
+
+/*
+ * Cost-aware chunking of porpoise loops. The cost of a porpoise's turn varies a
+ * lot (a forager does one CRW move, a disperser runs several path searches), so
+ * splitting a loop into equally sized chunks leaves threads idle behind the one
+ * that got the dispersers. Instead, the (shuffled) update order is cut into
+ * consecutive chunks of roughly equal estimated cost, and the chunks are handed
+ * out dynamically, so threads that finish early pick up the remaining chunks.
+ * The update order within and between chunks is unchanged, so with one thread
+ * porpoises still act in the shuffled order.
+ */
+class Schedule {
+private:
+    std::vector<int> m_bounds { 0 }; // chunk c covers [m_bounds[c], m_bounds[c+1])
+    std::vector<float> m_cost;
+public:
+    static const int chunksPerThread = 8;
+    static constexpr float minChunkCost = 64.0f; // don't bother splitting below this
+
+    // cost(j) returns the estimated cost of the j'th porpoise in the update order
+    template<typename F>
+    void partition(int n, int nThread, F cost) {
+        m_cost.resize(n);
+        float total = 0.0f;
+        for (int j = 0; j < n; ++j) {
+            m_cost[j] = cost(j);
+            total += m_cost[j];
+        }
+
+        int nChunk = std::max(1, std::min(nThread * chunksPerThread, (int) (total / minChunkCost)));
+        float target = total / nChunk;
+        float acc = 0.0f;
+        m_bounds.assign(1, 0);
+        for (int j = 0; j < n; ++j) {
+            acc += m_cost[j];
+            if (acc >= target && (int) m_bounds.size() < nChunk) {
+                m_bounds.push_back(j + 1);
+                acc = 0.0f;
+            }
+        }
+        if (m_bounds.back() != n) m_bounds.push_back(n);
+    }
+    int size() const { return m_bounds.size() - 1; }
+    int begin(int chunk) const { return m_bounds[chunk]; }
+    int end(int chunk) const { return m_bounds[chunk + 1]; }
+};
+
+/*
+ * Per-thread busy and idle time in the porpoise loops. Busy time is spent
+ * processing chunks, idle time is the remainder of the loop's wall time,
+ * i.e. waiting for other threads at the end of the loop.
+ */
+class ThreadStats {
+private:
+    std::vector<double> m_busy, m_wall;
+public:
+    void reset(int nThread) {
+        m_busy.assign(nThread, 0.0);
+        m_wall.assign(nThread, 0.0);
+    }
+    void addBusy(double seconds) {
+        int t = omp_get_thread_num();
+        if (t < (int) m_busy.size()) m_busy[t] += seconds;
+    }
+    void addWall(double seconds) {
+        int t = omp_get_thread_num();
+        if (t < (int) m_wall.size()) m_wall[t] += seconds;
+    }
+    int size() const { return m_busy.size(); }
+    double busy(int thread) const { return m_busy[thread]; }
+    double idle(int thread) const { return m_wall[thread] - m_busy[thread]; }
+};
+
+#endif // __SCHEDULER__
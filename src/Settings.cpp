@@ -8,87 +8,240 @@
 #include "Gillnet.h"
 #include "Block.hpp"
 #include "Porpoise.hpp"
+#include "LandscapeCache.hpp"
+#include "TileCache.hpp"
+#include "omp.h"
 
-Settings::Settings(Rcpp::List& conf) {
+// gillnets and porpoises are deleted first, as they take themselves off the grid and calendars
+Settings::~Settings() {
+    Gillnets.clear();
+    Porpoises.clear();
+}
+
+// Reads the landscape and fishery data. These are not changed by simulations, so one
+// Settings can be loaded once and then used for many runs (see load_landscape() in R)
+void Settings::loadLandscape(Rcpp::List& conf) {
     using namespace Rcpp;
     
-    Porpoise::sim = { this };
-    Block::sim = { this };
-    Gillnet::sim = { this };
-    abundanceRegion::_sim = { this };
-    
     nFisheryDataSampleSize= as<int>(conf["nFisheryDataSampleSize"]);
     nGillnetTypes = as<int>(conf["nGillnetTypes"]);
     MinimumWaterDepth = as<float>(conf["minTraversableWaterDepth"]);
+    maxU = as<float>(conf["maxU"]);
+    
+    // read data, or the preprocessed landscape if it is in the cache
+    std::string sasc = as<std::string>(conf["sasc"]);
+    std::string cacheFile;
+    uint64_t cacheKey = 0;
+    if (conf["cacheDir"] != R_NilValue) {
+        cacheKey = landscapeCacheKey(sasc, MinimumWaterDepth, maxU);
+        cacheFile = landscapeCacheFile(as<std::string>(conf["cacheDir"]), cacheKey);
+    }
+    
+    // with shareLandscape, cell data is used from the cache file, shared with other processes
+    bool share = !cacheFile.empty() && as<bool>(conf["shareLandscape"]);
+    // with landscapeTiles, it is read from a tile file as needed, so the cache is mapped rather than copied
+    int maxTiles = cacheFile.empty() ? 0 : as<int>(conf["landscapeTiles"]);
+    
+    if (!cacheFile.empty() && loadLandscapeCache(cacheFile, cacheKey, share || maxTiles > 0)) {
+        debug(0, "Read preprocessed landscape for %s from %s", sasc.c_str(), cacheFile.c_str());
+    } else {
+        debug(0, "Reading spatial data from %s", sasc.c_str());
+        read_gis(sasc, this);
+        postProcessData();
+        if (!cacheFile.empty()) {
+            debug(0, "Writing preprocessed landscape to %s", cacheFile.c_str());
+            saveLandscapeCache(cacheFile, cacheKey);
+            // swap our own copy of the cell data for the shared one
+            if (share && !loadLandscapeCache(cacheFile, cacheKey, true)) {
+                Rcpp::warning("Could not share the landscape from %s", cacheFile);
+            }
+        }
+    }
+    if (maxTiles > 0) {
+        std::string tileFile = landscapeTileFile(as<std::string>(conf["cacheDir"]), cacheKey);
+        std::unique_ptr<TileCache> tiles(new TileCache());
+        if (!tiles->open(tileFile, cacheKey, xmx, ymx, Landscape::nColumn, maxTiles)) {
+            debug(0, "Writing landscape tiles to %s", tileFile.c_str());
+            const void* columns[Landscape::nColumn];
+            for (int c = 0; c < Landscape::nColumn; ++c) columns[c] = landscape.column(c);
+            if (!TileCache::write(tileFile, cacheKey, xmx, ymx, Landscape::nColumn, columns)
+                    || !tiles->open(tileFile, cacheKey, xmx, ymx, Landscape::nColumn, maxTiles)) {
+                Rcpp::warning("Could not write landscape tiles to %s, the landscape is kept in memory", tileFile);
+                tiles.reset();
+            }
+        }
+        if (tiles) {
+            debug(1, "Cell data is read from %d tiles of %d x %d cells in %s, up to %d tiles per thread in memory", 
+                          tiles->nTile(), TileCache::tileSize, TileCache::tileSize, tileFile.c_str(), maxTiles);
+            landscape.useTiles(std::move(tiles));
+        }
+    }
+    if (landscape.shared()) {
+        debug(1, "Cell data is shared with other processes using %s", cacheFile.c_str());
+    }
+    buildPathGrid();
+    checkLandscape();
+    
+    // fishery data refers to the fishery regions of the landscape file
+    fishery.initialize(nFisheryBlocks + emptyFisheryBlocks.size(), nGillnetTypes, nFisheryDataSampleSize);
+    
+    if (conf["fish"] == R_NilValue || conf["effort"] == R_NilValue) {
+        debug(0, "Fishery or effort data not specified, gillnet agents disabled");
+    } else {
+        debug(0, "Reading fishery data from %s", as<std::string>(conf["fish"]).c_str());
+        stats_size = read_fishery_data(as<std::string>(conf["fish"]), fishery);
+        
+        debug(0, "Reading effort data from %s", as<std::string>(conf["effort"]).c_str());
+        effort_size = read_fishing_effort(as<std::string>(conf["effort"]), fishery);
+        fisheryEnabled = true;
+    }
+    
+    // and drops those without gillnet cells, as in FisheryBlocks
+    for (auto i = emptyFisheryBlocks.rbegin(); i != emptyFisheryBlocks.rend(); ++i) {
+        fishery.removeBlock(*i);
+    }
+}
+
+// Takes the landscape and fishery data read by loadLandscape from a loaded landscape,
+// for a run of its own. The cell data is shared with the loaded landscape, and the
+// rest (grid cells, blocks, regions) is copied, so that runs on the same loaded
+// landscape, one after the other or side by side, never see each other's state.
+void Settings::useLandscape(const Settings& loaded) {
+    fishery = loaded.fishery;
+    fisheryEnabled = loaded.fisheryEnabled;
+    FisheryBlocks = loaded.FisheryBlocks;
+    emptyFisheryBlocks = loaded.emptyFisheryBlocks;
+    abundanceRegions = loaded.abundanceRegions;
+    Blocks = loaded.Blocks;
+    landscape = loaded.landscape;
+    water = loaded.water;
+    Grid = loaded.Grid;
+    Patches = loaded.Patches;
+    pathGrid = loaded.pathGrid;
+    pathGridWidth = loaded.pathGridWidth;
+    xmn = loaded.xmn;
+    ymn = loaded.ymn;
+    xmx = loaded.xmx;
+    ymx = loaded.ymx;
+    ncell = loaded.ncell;
+    block_size = loaded.block_size;
+    std::copy(loaded.meanMaxent, loaded.meanMaxent + 4, meanMaxent);
+    nSurveyBlocks = loaded.nSurveyBlocks;
+    nFisheryBlocks = loaded.nFisheryBlocks;
+    nBlocks = loaded.nBlocks;
+    nFisheryDataSampleSize = loaded.nFisheryDataSampleSize;
+    nGillnetTypes = loaded.nGillnetTypes;
+    MinimumWaterDepth = loaded.MinimumWaterDepth;
+    maxU = loaded.maxU;
+    validSurveyBlocks = loaded.validSurveyBlocks;
+    effort_size = loaded.effort_size;
+    stats_size = loaded.stats_size;
+}
+
+void Settings::checkLandscape() const {
+    const TileCache* tiles = landscape.tiles();
+    int tile = tiles ? tiles->failedTile() : -1;
+    if (tile != -1) {
+        Rcpp::stop("Could not read tile %d of %s. Was the file changed or removed while in use?", tile, tiles->filename());
+    }
+}
+
+// Reads the parameters of a run, and resets the state changed by earlier runs on this landscape
+void Settings::configure(Rcpp::List& conf) {
+    using namespace Rcpp;
+    
     FoodGrowthRate = as<float>(conf["foodGrowthRate"]);
     offGridCellsTraversable = as<bool>(conf["offGridCellsTraversable"]);
-    maxU = as<float>(conf["maxU"]);
     pinger_effect = as<float>(conf["pingerEffect"]);
-    Porpoise::nextId = 0;
-    // set porpoise static members
-    Porpoise::AgeOfMaturity = as<float>(conf["ageOfMaturity"]);
+    
+    std::string entanglement = as<std::string>(conf["entanglementMode"]);
+    if (entanglement == "agent") {
+        entanglementMode = 1;
+    } else if (entanglement == "net") {
+        entanglementMode = 2;
+    } else {
+        entanglementMode = 0;
+    }
+    std::string interval = as<std::string>(conf["abundanceInterval"]);
+    if (interval == "day") {
+        abundanceInterval = 1;
+    } else if (interval == "step") {
+        abundanceInterval = 2;
+    } else {
+        abundanceInterval = 0;
+    }
+    densityDependentBlocks = as<bool>(conf["densityDependentBlocks"]);
+    if (landscape.tiles()) {
+        checkLandscape(); // before prepare() forgets failed reads
+        landscape.tiles()->prepare(omp_get_max_threads());
+    }
+    nextPorpoiseId = 0;
+    Porpoises.clear();
+    calendar.clear();
+    ageOuts.clear();
+    // set porpoise parameters
+    porpoise.AgeOfMaturity = as<float>(conf["ageOfMaturity"]);
     
     NumericVector tmp = conf["monthlyEnergyMultiplier"];
     for (int i = 0; i < 12; i++) {
-        Porpoise::monthlyEnergyMultiplier[i] = tmp[i];
+        porpoise.monthlyEnergyMultiplier[i] = tmp[i];
     }
-    Porpoise::withCalfEnergyMultiplier = as<float>(conf["withCalfEnergyMultiplier"]);
-    Porpoise::distEnergyMultiplier = as<float>(conf["distEnergyMultiplier"]);
-    Porpoise::stepEnergyMultiplier = as<float>(conf["stepEnergyMultiplier"]);
-    Porpoise::m_mort_prob = as<float>(conf["mMortProb"]);
-    Porpoise::x_surv_prob = as<float>(conf["xSurvProb"]);
-    Porpoise::dispersalInertia = as<int>(conf["dispersalInertia"]) - 1;
-    Porpoise::meanDispersalDistance = as<float>(conf["meanDispersalDistance"]);
-    Porpoise::minDispersalDistance = as<float>(conf["minDispersalDistance"]);
-    Porpoise::maxDispersalDistance = as<float>(conf["maxDispersalDistance"]);
-    Porpoise::minDispersalDistanceSquared = Porpoise::minDispersalDistance * Porpoise::minDispersalDistance;
-    Porpoise::maxDispersalDistanceSquared = Porpoise::maxDispersalDistance * Porpoise::maxDispersalDistance;
+    porpoise.withCalfEnergyMultiplier = as<float>(conf["withCalfEnergyMultiplier"]);
+    porpoise.distEnergyMultiplier = as<float>(conf["distEnergyMultiplier"]);
+    porpoise.stepEnergyMultiplier = as<float>(conf["stepEnergyMultiplier"]);
+    porpoise.m_mort_prob = as<float>(conf["mMortProb"]);
+    porpoise.x_surv_prob = as<float>(conf["xSurvProb"]);
+    porpoise.updateSurvivalTable();
+    porpoise.dispersalInertia = as<int>(conf["dispersalInertia"]) - 1;
+    porpoise.meanDispersalDistance = as<float>(conf["meanDispersalDistance"]);
+    porpoise.minDispersalDistance = as<float>(conf["minDispersalDistance"]);
+    porpoise.maxDispersalDistance = as<float>(conf["maxDispersalDistance"]);
+    porpoise.minDispersalDistanceSquared = porpoise.minDispersalDistance * porpoise.minDispersalDistance;
+    porpoise.maxDispersalDistanceSquared = porpoise.maxDispersalDistance * porpoise.maxDispersalDistance;
         
-    Porpoise::minDispersalDepth = as<float>(conf["minDispersalDepth"]);
-    Porpoise::minDispersalDistanceToLand = as<float>(conf["minDispersalDistanceToLand"]);
-    Porpoise::pregnancy_prob = as<float>(conf["pregnancyProb"]);
-    Porpoise::max_age = as<float>(conf["maxAge"]);
-    Porpoise::maxMemory = as<int>(conf["memoryMax"]);
-    Porpoise::inertia_const = as<float>(conf["inertiaConst"]);
-    Porpoise::corrLogmov = as<float>(conf["corrLogmov"]);
-    Porpoise::corrAngle = as<float>(conf["corrAngle"]);
-    Porpoise::m = as<float>(conf["m"]);
-    Porpoise::maxLogmov = as<float>(conf["maxLogmov"]);
-    Porpoise::age_dist = as<std::vector<int>>(conf["ageDist"]);
-    Porpoise::ref_mem_strength = as<std::vector<float>>(conf["refMemStrength"]);
-    Porpoise::work_mem_strength = as<std::vector<float>>(conf["workMemStrength"]);
-    GridCell::foodGrowthRate = as<float>(conf["foodGrowthRate"]);
-    Gillnet::interaction_probability = as<std::vector<float>>(conf["interaction_probability"]);
-    Gillnet::m_catchability_by_type[0] = as<float>(conf["catchabilitySmall"]);
-    Gillnet::m_catchability_by_type[1] = as<float>(conf["catchabilityMedium"]);
-    Gillnet::m_catchability_by_type[2] = as<float>(conf["catchabilityLarge"]);
+    porpoise.minDispersalDepth = as<float>(conf["minDispersalDepth"]);
+    porpoise.minDispersalDistanceToLand = as<float>(conf["minDispersalDistanceToLand"]);
+    porpoise.pregnancy_prob = as<float>(conf["pregnancyProb"]);
+    porpoise.max_age = as<float>(conf["maxAge"]);
+    porpoise.maxMemory = as<int>(conf["memoryMax"]);
+    porpoise.inertia_const = as<float>(conf["inertiaConst"]);
+    porpoise.corrLogmov = as<float>(conf["corrLogmov"]);
+    porpoise.corrAngle = as<float>(conf["corrAngle"]);
+    porpoise.m = as<float>(conf["m"]);
+    porpoise.maxLogmov = as<float>(conf["maxLogmov"]);
+    porpoise.age_dist = as<std::vector<int>>(conf["ageDist"]);
+    porpoise.ref_mem_strength = as<std::vector<float>>(conf["refMemStrength"]);
+    porpoise.work_mem_strength = as<std::vector<float>>(conf["workMemStrength"]);
+    porpoise.setupMemory();
+    debug(1, "Working memory: %s, reference memory: %s", 
+          porpoise.work_mem_decay.valid ? "geometric decay" : "arbitrary weights", 
+          porpoise.ref_mem_decay.valid ? "geometric decay" : "arbitrary weights");
+    interaction_probability = as<std::vector<float>>(conf["interaction_probability"]);
+    catchability_by_type[0] = as<float>(conf["catchabilitySmall"]);
+    catchability_by_type[1] = as<float>(conf["catchabilityMedium"]);
+    catchability_by_type[2] = as<float>(conf["catchabilityLarge"]);
         
     int yday = as<int>(conf["start"]);
     float lastDayofSeason[4] = { 90, 181, 273, 365 };
     for (int i = 0; i < 4; ++i) {
         if (yday <= lastDayofSeason[i]) {
-            GridCell::setSeason(i);
+            season = i;
             break;
         }
     }
-    
-    // read data
-    Logger::debug(0, "Reading spatial data from %s", as<std::string>(conf["sasc"]).c_str());
-    read_gis(as<std::string>(conf["sasc"]), this);
-    
-    fishery.initialize(nFisheryBlocks, nGillnetTypes, nFisheryDataSampleSize);
-    
-    if (conf["fish"] == R_NilValue || conf["effort"] == R_NilValue) {
-        Logger::debug(0, "Fishery or effort data not specified, gillnet agents disabled");
-    } else {
-        Logger::debug(0, "Reading fishery data from %s", as<std::string>(conf["fish"]).c_str());
-        stats_size = read_fishery_data(as<std::string>(conf["fish"]), fishery);
-        
-        Logger::debug(0, "Reading effort data from %s", as<std::string>(conf["effort"]).c_str());
-        effort_size = read_fishing_effort(as<std::string>(conf["effort"]), fishery);
+    reset();
+}
+
+// restores food levels and block values to their starting values, and removes any gillnets
+void Settings::reset() {
+    Gillnets.clear();
+    for (auto& cell : Grid) {
+        cell.reset(*this);
+    }
+    for (auto& block : Blocks) {
+        block.setN(1);
+        block.calcDensity(*this);
     }
-    
-    postProcessData();
 }
 
 void Settings::initData(int x, int y, int nsurv, int nfish, int nblock, int ntrav, int bsize, int npatch, float meanMaxent1, float meanMaxent2, float meanMaxent3, float meanMaxent4) {
@@ -100,28 +253,26 @@ void Settings::initData(int x, int y, int nsurv, int nfish, int nblock, int ntra
     nFisheryBlocks = nfish;
     nBlocks = nblock;
     
-    Block::m_xmax = xmx;
-    Block::m_ymax = ymx;
-    Block::m_ncell = ncell;
-    
     Blocks.reserve(nBlocks);
     for (int i = 0; i < nBlocks; ++i) {
         Blocks.emplace_back();
     }
-    Grid.reserve(ncell);
+    water.reset(ncell);
+    Grid.reserve(ntrav);
     Patches.reserve(npatch);
-    TraversableCells.reserve(ntrav);
     
     abundanceRegions.resize(nSurveyBlocks);
     FisheryBlocks.resize(nFisheryBlocks);
     
-    GridCell::meanSeasonalMaxent[0] = meanMaxent1;
-    GridCell::meanSeasonalMaxent[1] = meanMaxent2;
-    GridCell::meanSeasonalMaxent[2] = meanMaxent3;
-    GridCell::meanSeasonalMaxent[3] = meanMaxent4;
+    meanMaxent[0] = meanMaxent1;
+    meanMaxent[1] = meanMaxent2;
+    meanMaxent[2] = meanMaxent3;
+    meanMaxent[3] = meanMaxent4;
 }
 
 void Settings::postProcessData() {
+    int32_t* blocks = landscape.ints(Landscape::FoodBlock);
+    int32_t* regions = landscape.ints(Landscape::AbundanceRegion);
 
     // Go over blocks:
     // 1) delete blocks that contain no traversable cells
@@ -135,10 +286,10 @@ void Settings::postProcessData() {
             Blocks.erase(Blocks.begin()+i);
         } else {
             for (auto& cell : Blocks[i].m_cells) {
-                Grid[cell].Block = i;
+                blocks[water.cell(cell)] = i;
             }
             Blocks[i].calcCenter();
-            Blocks[i].calcDensity();
+            Blocks[i].calcDensity(*this);
             Blocks[i].setId(i);
             ++i;
         }
@@ -149,7 +300,7 @@ void Settings::postProcessData() {
             abundanceRegions.erase(abundanceRegions.begin()+i);
         } else {
             for (auto& cell : abundanceRegions[i]._cells) {
-                Grid[cell].abundanceBlock = i;
+                regions[water.cell(cell)] = i;
             }
             abundanceRegions[i].setId(i);
             ++i;
@@ -157,15 +308,17 @@ void Settings::postProcessData() {
     }
     
     // delete fishing areas which contain no traversable cells,
-    // or where the fishing effort is zero for all seasons
-    for (int i = 0; i < FisheryBlocks.size();) {
+    // or where the fishing effort is zero for all seasons.
+    // The fishery data is read later, and these are removed from it then
+    int kept = 0;
+    for (int i = 0; i < FisheryBlocks.size(); ++i) {
         if (FisheryBlocks[i].size() == 0) { 
-            FisheryBlocks.erase(FisheryBlocks.begin() + i);
-            fishery.removeBlock(i);
+            emptyFisheryBlocks.push_back(i);
         } else {
-            ++i;
+            FisheryBlocks[kept++].swap(FisheryBlocks[i]);
         }
     }
+    FisheryBlocks.resize(kept);
 
     Blocks.shrink_to_fit();
     FisheryBlocks.shrink_to_fit();
@@ -215,9 +368,9 @@ Vector2df Settings::randomPoint(int a) {
     int cellnum;
     
     if (a == -1 || a >= nSurveyBlocks) {
-        cellnum = *select_randomly(TraversableCells.begin(), TraversableCells.end());
+        cellnum = water.cell(getRandomInt(0, water.size() - 1));
     } else {
-        cellnum = abundanceRegions[a].randomCell();
+        cellnum = water.cell(abundanceRegions[a].randomCell());
     }
     
     Vector2df pos{pointFromCell(cellnum)};
@@ -265,7 +418,7 @@ Vector2df Settings::findPathDeepest(Vector2df currentPos, Vector2df mov, float o
             if (IsPathTraversable(currentPos.x, currentPos.y, currentPos.x + distantPt.x, currentPos.y + distantPt.y)) {
                 int cell = cellFromPoint(currentPos + candidateMov);
                 if (cell != -1) {
-                    float bathy = Grid[cell].Bathymetry;
+                    float bathy = landscape.bathymetry(cell);
                     if (bathy < bestDepth) {
                         bestDepth = bathy;
                         newMov = candidateMov;
@@ -295,7 +448,7 @@ Vector2df Settings::findPathFarthestFromShore(Vector2df currentPos, Vector2df mo
             if (IsPathTraversable(currentPos.x, currentPos.y, currentPos.x + candidateMov.x, currentPos.y + candidateMov.y)) {
                 int cell = cellFromPoint(candidateMov);
                 if (cell != -1) {
-                    float dist = Grid[cell].DistanceToCoast;
+                    float dist = landscape.distToCoast(cell);
                     if (dist < bestDist) {
                         bestDist = dist;
                         newMov = candidateMov;
@@ -314,7 +467,7 @@ Vector2df Settings::findPathParallellToCoast(Vector2df currentPos, Vector2df mov
     int cell = cellFromPoint(currentPos);
     if (cell == -1) return newMov; // for now.
     
-    float currentDist = Grid[cell].DistanceToCoast;
+    float currentDist = landscape.distToCoast(cell);
     float bestDist = -1; // impossible value. We'll use this to check if this var is "initalized" or not
     offset *= PI/180; // degrees to radians
     step *= PI/180;
@@ -330,7 +483,7 @@ Vector2df Settings::findPathParallellToCoast(Vector2df currentPos, Vector2df mov
                 int cellno = cellFromPoint(currentPos + candidateMov);
                 if (cellno == -1) continue;
                 
-                float dist = Grid[cellno].DistanceToCoast;
+                float dist = landscape.distToCoast(cellno);
                 if (bestDist == -1) {
                     bestDist = dist;
                     newMov = candidateMov;
@@ -370,10 +523,9 @@ void Settings::adjustMoveToAvoidShallowWater(Porpoise* porp, Vector2df& newPos,
     // so we can skip any shallow water checks
     /*
     if (currentCell != -1) {
-        auto& cell = Grid[currentCell];
         int dist = 1.25 * Distance;
         
-        if (cell.DistanceToCoast > dist && cell.DistanceToEdge > dist) {
+        if (landscape.distToCoast(currentCell) > dist && landscape.distToEdge(currentCell) > dist) {
             return;
         }
     }
@@ -436,71 +588,60 @@ void Settings::adjustMoveToAvoidShallowWater(Porpoise* porp, Vector2df& newPos,
 }
 
 
-// IsPathTraversable: iterates over all the individual cells found by 
-// running the GetCellsIntersected function (i.e. those cells that
+// Holds, for each point (x, y) with integer coordinates in and around the grid, whether
+// the cell that cellFromXY(x, y) gives is traversable, so paths can be checked without
+// computing cell numbers. Points on the right and bottom edges of the grid belong to the
+// last column and row, as in cellFromXY, and points off the grid are marked as such, for
+// IsPathTraversable to decide per run (see offGridCellsTraversable).
+void Settings::buildPathGrid() {
+    pathGridWidth = xmx + 2 * pathGridPadding;
+    int height = ymx + 2 * pathGridPadding;
+    pathGrid.assign((size_t) pathGridWidth * height, PathOffGrid);
+    for (int r = 0; r < height; ++r) {
+        int row = r - pathGridPadding;
+        if (row == ymx) --row;
+        if (row < 0 || row >= ymx) continue;
+        for (int c = 0; c < pathGridWidth; ++c) {
+            int col = c - pathGridPadding;
+            if (col == xmx) --col;
+            if (col < 0 || col >= xmx) continue;
+            bool traversable = landscape.bathymetry(row * xmx + col) <= MinimumWaterDepth;
+            pathGrid[(size_t) r * pathGridWidth + c] = traversable ? PathWater : PathLand;
+        }
+    }
+}
+
+// IsPathTraversable: iterates over all the individual cells that
 // intersect with a line segment as defined by the point XY and the 
-// point newXnewY) and checks the water depth in those cells. If at
-// least one cell is too shallow, the function return false.
+// point newXnewY (as found by GetCellsIntersected) and checks the water
+// depth in those cells. If at least one cell is too shallow, the
+// function return false.
 // Cells that fall outside the grid are considered traversable if
 // offGridCellsTraversable is true.
 bool Settings::IsPathTraversable(float x, float y, float newX, float newY) {
     
-    if (!isCoordValid(Vector2df(newX, newY))) return false;
-
-    std::vector<int> cellsInPath = GetCellsIntersected(x, y, newX, newY);
-    if (cellsInPath.size() == 0) return false;
-    
-    for (const int& cell : cellsInPath) {
-        if (cell == -1 || Grid[cell].Bathymetry > MinimumWaterDepth) {
-            return false;
-        }
-    }
-    return true;
+    if (!isCoordValid(Vector2df(newX, newY)) || !isCoordValid(Vector2df(x, y))) return false;
+    
+    // both ends are on the grid, so the cells crossed are at most one cell off it,
+    // and always in pathGrid
+    const uint8_t pass = offGridCellsTraversable ? PathWater | PathOffGrid : PathWater;
+    const uint8_t* grid = pathGrid.data() + (size_t) (ymx + pathGridPadding) * pathGridWidth + pathGridPadding;
+    const int width = pathGridWidth;
+    bool traversable = true;
+    forCellsIntersected(xmx, ymx, x, y, newX, newY, [&](int cx, int cy) {
+        traversable = grid[cx - cy * width] & pass;
+        return traversable;
+    });
+    return traversable;
 }
-// Fast Voxel Traversal Algorithm
-// https://www.researchgate.net/publication/2611491_A_Fast_Voxel_Traversal_Algorithm_for_Ray_Tracing
-// https://github.com/cgyurgyik/fast-voxel-traversal-algorithm/blob/master/overview/FastVoxelTraversalOverview.md
+
+// cell numbers of the cells intersected by the line segment from XY to newXnewY,
+// -1 for cells off the grid
 std::vector<int> Settings::GetCellsIntersected(float X, float Y, float newX, float newY) {
-    auto frac_pos = [](float x) { return 1 - x + floorf(x); };
-    auto frac_neg = [](float x) { return x - floorf(x); };
-    
-    float xstep = newX - X;
-    float ystep = newY - Y;
-    float tDeltaX = xmx;
-    float tDeltaY = ymx;
-    int dx = (xstep > 0 ? 1 : (xstep < 0 ? -1 : 0));
-    int dy = (ystep > 0 ? 1 : (ystep < 0 ? -1 : 0));
-    if (dx != 0) tDeltaX = abs(fmin(dx / xstep, xmx));
-    if (dy != 0) tDeltaY = abs(fmin(dy / ystep, ymx));
-    float tMaxX, tMaxY;
-    
-    if (dx > 0) {
-        tMaxX = frac_pos(X) * tDeltaX;
-    } else {
-        tMaxX = frac_neg(X) * tDeltaX;
-    }
-    
-    if (dy > 0) {
-        tMaxY = frac_pos(Y) * tDeltaY;
-    } else {
-        tMaxY = frac_neg(Y) * tDeltaY;
-    }
-    
-    int x = (int) X;
-    int y = (int) Y;
     std::vector<int> cellNumbers;
-    int j = 0;
-    while (true) {
-        if (tMaxX < tMaxY) {
-            x += dx;
-            tMaxX += tDeltaX;
-        } else {
-            y += dy;
-            tMaxY += tDeltaY;
-        }
+    forCellsIntersected(xmx, ymx, X, Y, newX, newY, [&](int x, int y) {
         cellNumbers.push_back(cellFromXY(x, y));
-        j++;
-        if ((tMaxX > 1 && tMaxY > 1) || j == 200) break;
-    }
+        return true;
+    });
     return cellNumbers;
 }
@@ -1,6 +1,7 @@
 #ifndef __SETTINGS__
 #define __SETTINGS__
 #include <Rcpp.h>
+#include <memory>
 
 #include "misc.hpp"
 #include "Vector2d.hpp"
@@ -10,6 +11,14 @@
 #include "abundanceRegion.hpp"
 #include "Fishery.hpp"
 #include "FishingEffort.hpp"
+#include "Scheduler.hpp"
+#include "PopulationCounters.hpp"
+#include "Landscape.hpp"
+#include "CellIndex.hpp"
+#include "EventCalendar.hpp"
+#include "PorpoiseParameters.hpp"
+#include "RandomStream.hpp"
+#include "StepState.hpp"
 
 // forward declarations
 class GridCell;
@@ -18,29 +27,49 @@ class Block;
 class abundanceRegion;
 class Logger;
 class Porpoise;
-extern int DEBUG_LEVEL;
 
+/*
+ * The landscape, fishery and state of one simulation. Agents reach it through
+ * their sim pointer, and nothing about a run is held outside it, so simulations
+ * with a Settings of their own can run side by side in one process. A landscape
+ * loaded once (see load_landscape() in R) is not run itself: each run takes a
+ * Settings of its own that shares the cell data (see useLandscape).
+ */
 class Settings {
 public:
     // simulation data
     Fishery fishery;
+    bool fisheryEnabled = false; // fishery and effort data were given, so gillnets are set
     std::list<Gillnet> Gillnets; // for fast random erase
-    std::vector<int> TraversableCells;
     std::vector<std::vector<int>> FisheryBlocks;
+    std::vector<int> emptyFisheryBlocks; // fishery regions in the landscape file without any gillnet cells, removed from FisheryBlocks
     std::vector<abundanceRegion> abundanceRegions;
     std::vector<Block> Blocks;
-    std::vector<GridCell> Grid;
+    Landscape landscape; // cell data that does not change during a run
+    CellIndex water; // numbers the traversable cells; Grid, Patches, and the cells of blocks and abundance regions use these numbers
+    std::vector<GridCell> Grid; // cell data that does change, for traversable cells only
     std::vector<int> Patches;
+    std::vector<uint8_t> pathGrid; // traversability of the cells, with a border of off-grid cells (see buildPathGrid)
+    int pathGridWidth = 0;
+    static const int pathGridPadding = 2;
+    enum PathCell : uint8_t { PathLand = 0, PathWater = 1, PathOffGrid = 2 };
     Logger *logger;
     Timer *time;
+    int debugLevel = 0; // verbosity of console messages (debug in R), see debug()
+    ThreadStats threadStats; // busy/idle time per thread in the porpoise loops
+    PopulationCounters counters; // porpoises per abundance region, block and age class
+    int abundanceInterval = 0; // abundance per region is logged 0: monthly, 1: daily, 2: every step
+    bool densityDependentBlocks = false; // divide block values by the number of porpoises in the block
     int xmn = 0;
     int ymn = 0;
-    int xmx, ymx, ncell, block_size;
+    int xmx = 0, ymx = 0, ncell = 0, block_size = 0;
+    float meanMaxent[4] {}; // mean seasonal maxent values of the landscape, which food levels are relative to
     int nSurveyBlocks, nFisheryBlocks, nBlocks;
     int nFisheryDataSampleSize, nGillnetTypes;
-    bool offGridCellsTraversable;
+    bool offGridCellsTraversable = false;
     float MinimumWaterDepth;
     float FoodGrowthRate; 
+    int season = 0; // current season (0-3), for food levels
     float maxU;
     int QuarterStartingDay[4] = {1, 91, 182, 274};
     std::vector<int> validSurveyBlocks;
@@ -48,11 +77,31 @@ public:
     int effort_size = 0;
     int stats_size = 0;
     float pinger_effect {0.5};
+    int entanglementMode {0}; // 0 = pick automatically, 1 = agent-centric, 2 = net-centric
+    std::vector<float> interaction_probability; // of porpoises with gillnets, by distance (see Gillnet::check4)
+    float catchability_by_type[3] {}; // of porpoises in gillnets, by gillnet type
+    
+    // porpoises. The calendars are declared first, as porpoises cancel their events when deleted
+    PorpoiseParameters porpoise;
+    EventCalendar calendar; // mating, births and weaning
+    EventCalendar ageOuts; // days on which porpoises are checked against max_age
+    std::vector<std::unique_ptr<Porpoise>> Porpoises;
+    int nextPorpoiseId = 0;
+    StepState step; // of the half-hour and daily tasks
+    RandomStreams random; // one stream per thread
 
     // functions
-    Settings(Rcpp::List& conf);
+    ~Settings();
+    void loadLandscape(Rcpp::List& conf);
+    void useLandscape(const Settings& loaded);
+    void configure(Rcpp::List& conf);
+    void reset();
     void initData(int x, int y, int nsurv, int nfish, int nblock, int ntrav, int bsize, int npatch,  float meanMaxent1, float meanMaxent2, float meanMaxent3, float meanMaxent4);
     void postProcessData();
+    void buildPathGrid();
+    void checkLandscape() const; // stops if cell data could not be read from the tile file
+    bool loadLandscapeCache(const std::string& filename, uint64_t key, bool share);
+    void saveLandscapeCache(const std::string& filename, uint64_t key) const;
     std::vector<int> GetCellsIntersected(float X, float Y, float newX, float newY);
     bool IsPathTraversable(float X, float Y, float newX, float newY);
     int cellFromPoint(Vector2df pt);
@@ -67,6 +116,16 @@ public:
     Vector2df findPathParallellToCoast(Vector2df currentPos, Vector2df mov, float offset, float step, float min, float max);
     void adjustMoveToAvoidShallowWater(Porpoise* porp, Vector2df& newPos, float& TurningAngle, float& Distance);
     static float subtract_headings(const float origin, const float destination);
+    // prints a console message if debugLevel is at least level
+    template <typename... Args>
+    void debug(int level, const char* format, Args... args) const {
+        if (debugLevel < level) return;
+        
+        std::string formatAsString = "";
+        formatAsString += format;
+        formatAsString += "\n";
+        Rprintf(formatAsString.c_str(), args...);
+    }
     /*void calcBlockAverageFood();
     int blockFromXY(float x, float y);
     int rowFromCell(const float& xmx, const int& cell);
@@ -78,4 +137,53 @@ public:
 
 };
 
+// Fast Voxel Traversal Algorithm
+// https://www.researchgate.net/publication/2611491_A_Fast_Voxel_Traversal_Algorithm_for_Ray_Tracing
+// https://github.com/cgyurgyik/fast-voxel-traversal-algorithm/blob/master/overview/FastVoxelTraversalOverview.md
+// Calls f(x, y) with the integer coordinates of each cell intersected by the line segment
+// from XY to newXnewY, in order, until f returns false
+template<class F>
+void forCellsIntersected(int xmx, int ymx, float X, float Y, float newX, float newY, F f) {
+    auto frac_pos = [](float x) { return 1 - x + floorf(x); };
+    auto frac_neg = [](float x) { return x - floorf(x); };
+    
+    float xstep = newX - X;
+    float ystep = newY - Y;
+    float tDeltaX = xmx;
+    float tDeltaY = ymx;
+    int dx = (xstep > 0 ? 1 : (xstep < 0 ? -1 : 0));
+    int dy = (ystep > 0 ? 1 : (ystep < 0 ? -1 : 0));
+    if (dx != 0) tDeltaX = abs(fmin(dx / xstep, xmx));
+    if (dy != 0) tDeltaY = abs(fmin(dy / ystep, ymx));
+    float tMaxX, tMaxY;
+    
+    if (dx > 0) {
+        tMaxX = frac_pos(X) * tDeltaX;
+    } else {
+        tMaxX = frac_neg(X) * tDeltaX;
+    }
+    
+    if (dy > 0) {
+        tMaxY = frac_pos(Y) * tDeltaY;
+    } else {
+        tMaxY = frac_neg(Y) * tDeltaY;
+    }
+    
+    int x = (int) X;
+    int y = (int) Y;
+    int j = 0;
+    while (true) {
+        if (tMaxX < tMaxY) {
+            x += dx;
+            tMaxX += tDeltaX;
+        } else {
+            y += dy;
+            tMaxY += tDeltaY;
+        }
+        if (!f(x, y)) break;
+        j++;
+        if ((tMaxX > 1 && tMaxY > 1) || j == 200) break;
+    }
+}
+
 #endif // __SETTINGS__
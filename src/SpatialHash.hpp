@@ -0,0 +1,66 @@
+#ifndef __SPATIALHASH__
+#define __SPATIALHASH__
+#include <vector>
+
+/*
+ * Hashes porpoises by the cell they occupy, so that everything in a given cell
+ * can be looked up without visiting every porpoise. The table is rebuilt each
+ * step with a counting sort over hash buckets, and its storage is reused
+ * between steps, so building it does not allocate once it has reached the
+ * size of the population.
+ */
+class SpatialHash {
+private:
+    unsigned int m_mask { 0 };
+    std::vector<int> m_start; // offset of the first entry in each bucket (size = number of buckets + 1)
+    std::vector<int> m_keys; // cell number of each entry, grouped by bucket
+    std::vector<int> m_values; // porpoise index of each entry, grouped by bucket
+    std::vector<int> m_bucket; // bucket of each porpoise (-1 if not inserted)
+    std::vector<int> m_cursor; // write position in each bucket while building
+
+    unsigned int bucket(int key) const {
+        return (static_cast<unsigned int>(key) * 2654435761u) & m_mask; // Knuth's multiplicative hash
+    }
+
+public:
+    // keyOf(i) returns the cell number of porpoise i, or -1 to leave it out
+    template<typename F>
+    void build(int n, F keyOf) {
+        unsigned int nbucket = 16;
+        while (nbucket < 2u * n) nbucket <<= 1;
+        m_mask = nbucket - 1;
+        m_start.assign(nbucket + 1, 0);
+        m_bucket.resize(n);
+
+        for (int i = 0; i < n; ++i) {
+            int key = keyOf(i);
+            m_bucket[i] = key == -1 ? -1 : (int) bucket(key);
+            if (m_bucket[i] != -1) ++m_start[m_bucket[i] + 1];
+        }
+        for (unsigned int b = 0; b < nbucket; ++b) {
+            m_start[b + 1] += m_start[b];
+        }
+
+        m_keys.resize(m_start[nbucket]);
+        m_values.resize(m_start[nbucket]);
+        m_cursor.assign(m_start.begin(), m_start.end() - 1);
+        for (int i = 0; i < n; ++i) {
+            if (m_bucket[i] == -1) continue;
+            int pos = m_cursor[m_bucket[i]]++;
+            m_keys[pos] = keyOf(i);
+            m_values[pos] = i;
+        }
+    }
+
+    // calls fn(i) for every porpoise i in the given cell
+    template<typename F>
+    void query(int key, F fn) const {
+        if (key == -1 || m_start.empty()) return;
+        unsigned int b = bucket(key);
+        for (int pos = m_start[b]; pos < m_start[b + 1]; ++pos) {
+            if (m_keys[pos] == key) fn(m_values[pos]);
+        }
+    }
+};
+
+#endif // __SPATIALHASH__
@@ -0,0 +1,26 @@
+#ifndef __STEPSTATE__
+#define __STEPSTATE__
+#include <vector>
+#include "SpatialHash.hpp"
+#include "Scheduler.hpp"
+
+/*
+ * State of the current step of one simulation, shared by the team of threads
+ * running execHalfhourTasks and execDailyTasks. Kept between steps, so that the
+ * vectors only allocate when the population grows.
+ */
+struct StepState {
+    int N { 0 };
+    std::vector<int> casualties; // holds indices of porpoises that died in this step
+    std::vector<int> indices;
+    std::vector<char> active; // porpoises still acting after moving
+    std::vector<char> entangled;
+    bool netCentric { true }, newDay { false };
+    Schedule firstPassSchedule;
+    std::vector<int> batches[3]; // porpoises by movement mode, after eating
+    Schedule batchSchedule[3];
+    SpatialHash porpsByCell; // for net-centric entanglement
+    std::vector<int> aged; // indices of porpoises reaching max_age today
+};
+
+#endif // __STEPSTATE__
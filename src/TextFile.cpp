@@ -0,0 +1,183 @@
+#include <cstring>
+#include <cstdlib>
+#include <algorithm>
+#include "TextFile.hpp"
+
+static const size_t minChunkSize = 1 << 16; // bytes
+static const int chunksPerThread = 4;
+
+// powers of ten that are exact as doubles
+static const double exactPowers[] = { 1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+                                      1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22 };
+
+static bool isBlank(char c) {
+    return c == ' ' || c == '\t';
+}
+
+static bool isDigit(char c) {
+    return c >= '0' && c <= '9';
+}
+
+const char* TextFile::lineEnd(const char* p, const char* end) {
+    const char* eol = static_cast<const char*>(std::memchr(p, '\n', end - p));
+    return eol == nullptr ? end : eol;
+}
+
+TextFile::Fields TextFile::split(const char* begin, const char* end) {
+    Fields fields;
+    fields.n = 0;
+    if (end > begin && end[-1] == '\r') --end;
+    const char* p = begin;
+    while (p < end) {
+        const char* q = static_cast<const char*>(std::memchr(p, ';', end - p));
+        if (q == nullptr) q = end;
+        if (q > p) {
+            if (fields.n < maxField) {
+                fields.begin[fields.n] = p;
+                fields.end[fields.n] = q;
+            }
+            ++fields.n;
+        }
+        p = q + 1;
+    }
+    return fields;
+}
+
+bool TextFile::parseInt(const char* p, const char* end, int32_t& value) {
+    while (p < end && isBlank(*p)) ++p;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) ++p;
+    if (p == end || !isDigit(*p)) return false;
+    int64_t x = 0;
+    while (p < end && isDigit(*p)) {
+        x = x * 10 + (*p - '0');
+        if (x > INT32_MAX) return false;
+        ++p;
+    }
+    value = negative ? -x : x;
+    return true;
+}
+
+bool TextFile::parseFloat(const char* begin, const char* end, float& value) {
+    const char* p = begin;
+    while (p < end && isBlank(*p)) ++p;
+    bool negative = p < end && *p == '-';
+    if (p < end && (*p == '-' || *p == '+')) ++p;
+
+    uint64_t mantissa = 0;
+    int digits = 0, exponent = 0;
+    bool any = false;
+    for (; p < end && isDigit(*p); ++p, any = true) {
+        if (digits < 19) {
+            mantissa = mantissa * 10 + (*p - '0');
+            if (mantissa > 0) ++digits;
+        } else {
+            ++exponent;
+        }
+    }
+    if (p < end && *p == '.') {
+        for (++p; p < end && isDigit(*p); ++p, any = true) {
+            if (digits < 19) {
+                mantissa = mantissa * 10 + (*p - '0');
+                if (mantissa > 0) ++digits;
+                --exponent;
+            }
+        }
+    }
+    if (any && p < end && (*p == 'e' || *p == 'E')) {
+        const char* q = p + 1;
+        bool negativeExponent = q < end && *q == '-';
+        if (q < end && (*q == '-' || *q == '+')) ++q;
+        if (q < end && isDigit(*q)) {
+            int e = 0;
+            for (; q < end && isDigit(*q); ++q) {
+                if (e < 10000) e = e * 10 + (*q - '0');
+            }
+            exponent += negativeExponent ? -e : e;
+        }
+    }
+
+    if (any && mantissa < (uint64_t(1) << 53) && exponent >= -22 && exponent <= 22) {
+        // exact mantissa and power of ten, so a single rounding
+        double x = mantissa;
+        x = exponent < 0 ? x / exactPowers[-exponent] : x * exactPowers[exponent];
+        value = negative ? -x : x;
+        return true;
+    }
+
+    // rare cases (long exponents, inf, nan): let the C library do it, on a terminated copy
+    char buffer[64];
+    size_t n = std::min<size_t>(end - begin, sizeof buffer - 1);
+    std::memcpy(buffer, begin, n);
+    buffer[n] = '\0';
+    char* last;
+    value = std::strtof(buffer, &last);
+    return last != buffer;
+}
+
+bool TextFile::open(const std::string& filename) {
+    m_chunks.clear();
+    m_nRow = 0;
+    if (!m_file.open(filename)) return false;
+
+    const char* begin = m_file.data();
+    const char* end = begin + m_file.size();
+    if (begin == nullptr) { // empty file
+        m_headerEnd = nullptr;
+        return true;
+    }
+    m_headerEnd = lineEnd(begin, end);
+    const char* body = std::min(m_headerEnd + 1, end);
+
+    // split the data lines into ranges of whole lines
+    size_t size = end - body;
+    int nChunk = std::max<size_t>(1, std::min<size_t>(omp_get_max_threads() * chunksPerThread, size / minChunkSize));
+    const char* p = body;
+    for (int k = 0; k < nChunk; ++k) {
+        const char* q = k == nChunk - 1 ? end : body + size * (k + 1) / nChunk;
+        if (q < p) q = p;
+        if (q < end && q > body && q[-1] != '\n') q = std::min(lineEnd(q, end) + 1, end);
+        m_chunks.push_back(Chunk { p, q, 0, 0, false });
+        p = q;
+    }
+
+    countRows();
+    return true;
+}
+
+void TextFile::countRows() {
+    const int nChunk = m_chunks.size();
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < nChunk; ++k) {
+        Chunk& chunk = m_chunks[k];
+        const char* p = chunk.begin;
+        while (p < chunk.end) {
+            const char* eol = lineEnd(p, chunk.end);
+            if (eol == p || (eol == p + 1 && *p == '\r')) {
+                chunk.hasEmptyLine = true;
+                break;
+            }
+            ++chunk.nRow;
+            p = eol + 1;
+        }
+    }
+
+    // the data ends at the first empty line
+    bool ended = false;
+    for (auto& chunk : m_chunks) {
+        if (ended) chunk.nRow = 0;
+        chunk.firstRow = m_nRow;
+        m_nRow += chunk.nRow;
+        ended = ended || chunk.hasEmptyLine;
+    }
+}
+
+TextFile::Fields TextFile::header() const {
+    if (m_headerEnd == nullptr) {
+        Fields fields;
+        fields.n = 0;
+        return fields;
+    }
+    return split(m_file.data(), m_headerEnd);
+}
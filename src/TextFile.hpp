@@ -0,0 +1,101 @@
+#ifndef __TEXTFILE__
+#define __TEXTFILE__
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "omp.h"
+#include "MappedFile.hpp"
+
+/*
+ * Parallel reader for the semicolon separated text files used by posim (sasc,
+ * fishery and effort files): a header line, followed by data lines up to the
+ * first empty line or the end of the file.
+ *
+ * The file is memory-mapped and the data lines are split into ranges of whole
+ * lines, one per task. Each task parses its lines straight from the mapping,
+ * so no line or field is ever copied into a string, and hands each row to a
+ * callback together with its row number, so results can be written in place.
+ */
+class TextFile {
+public:
+    static const int maxField = 16;
+
+    // the fields of a line, empty fields skipped
+    struct Fields {
+        const char* begin[maxField];
+        const char* end[maxField];
+        int n; // number of fields on the line, which can exceed maxField
+
+        bool getInt(int i, int32_t& value) const { return parseInt(begin[i], end[i], value); }
+        bool getFloat(int i, float& value) const { return parseFloat(begin[i], end[i], value); }
+    };
+
+    // first bad line found by parse(), if any
+    struct Error {
+        int64_t line { -1 }; // in the file, counting from 1
+        int nField { 0 };
+        bool badCount { false }; // wrong number of fields, rather than a field that is not a number
+    };
+
+    bool open(const std::string& filename); // returns false if the file can't be opened
+    Fields header() const;
+    int64_t nRow() const { return m_nRow; }
+
+    // Calls f(row, fields) for each data line, from several threads, and returns the
+    // first line with fewer than minField or more than maxField fields, or for which f
+    // returns false. f must not throw, nor call back into R.
+    template<class F> Error parse(int minField, int maxField, F f) const;
+
+    static Fields split(const char* begin, const char* end);
+    // Like strtol and strtof, these ignore leading blanks and anything after the number
+    static bool parseInt(const char* begin, const char* end, int32_t& value);
+    static bool parseFloat(const char* begin, const char* end, float& value);
+
+private:
+    struct Chunk {
+        const char* begin;
+        const char* end;
+        int64_t firstRow;
+        int64_t nRow; // lines before the first empty line in the chunk
+        bool hasEmptyLine;
+    };
+
+    MappedFile m_file;
+    const char* m_headerEnd { nullptr };
+    std::vector<Chunk> m_chunks;
+    int64_t m_nRow { 0 };
+
+    static const char* lineEnd(const char* p, const char* end);
+    void countRows();
+};
+
+template<class F>
+TextFile::Error TextFile::parse(int minField, int maxField, F f) const {
+    const int nChunk = m_chunks.size();
+    std::vector<Error> errors(nChunk);
+
+    #pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < nChunk; ++k) {
+        const Chunk& chunk = m_chunks[k];
+        const char* p = chunk.begin;
+        for (int64_t i = 0; i < chunk.nRow; ++i) {
+            const char* eol = lineEnd(p, chunk.end);
+            Fields fields = split(p, eol);
+            bool badCount = fields.n < minField || fields.n > maxField;
+            if (badCount || !f(chunk.firstRow + i, fields)) {
+                errors[k].line = chunk.firstRow + i + 2; // after the header, counting from 1
+                errors[k].nField = fields.n;
+                errors[k].badCount = badCount;
+                break;
+            }
+            p = eol + 1;
+        }
+    }
+
+    for (const auto& error : errors) {
+        if (error.line != -1) return error;
+    }
+    return Error();
+}
+
+#endif // __TEXTFILE__
@@ -0,0 +1,160 @@
+#include <cstdio>
+#include <chrono>
+#include <algorithm>
+#include "TileCache.hpp"
+
+/*
+ * Tile files hold a fixed header, followed by the tiles in row-major order.
+ * Each tile holds one tileSize x tileSize block of each column in turn, and
+ * tiles on the right and bottom edges of the landscape are padded with zeros,
+ * so all tiles have the same size and tile t is at a fixed offset.
+ */
+
+static const char magic[8] = { 'P', 'O', 'S', 'I', 'M', 'T', 'I', 'L' };
+static const uint32_t version = 1;
+static const uint32_t byteOrderMark = 0x01020304;
+
+// odr-used (std::min takes references), so they need definitions before C++17
+const int TileCache::tileShift;
+const int TileCache::tileSize;
+const int TileCache::tileCells;
+
+struct TileHeader {
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint64_t key;
+    int32_t xmax, ymax, tileSize, nColumn;
+};
+
+bool TileCache::write(const std::string& filename, uint64_t key, int xmax, int ymax, int nColumn, const void* const* columns) {
+    // as with the landscape cache, write to a file of our own and then move it into place
+    std::string tmp = filename + "." + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    std::ofstream out(tmp, std::ios::out | std::ios::binary | std::ios::trunc);
+    if (!out.is_open()) return false;
+
+    TileHeader header {};
+    std::memcpy(header.magic, magic, sizeof magic);
+    header.version = version;
+    header.byteOrder = byteOrderMark;
+    header.key = key;
+    header.xmax = xmax;
+    header.ymax = ymax;
+    header.tileSize = tileSize;
+    header.nColumn = nColumn;
+    out.write(reinterpret_cast<const char*>(&header), sizeof header);
+
+    int tilesX = (xmax + tileSize - 1) / tileSize;
+    int tilesY = (ymax + tileSize - 1) / tileSize;
+    std::vector<uint32_t> tile((size_t) nColumn * tileCells);
+    for (int ty = 0; ty < tilesY; ++ty) {
+        for (int tx = 0; tx < tilesX; ++tx) {
+            std::fill(tile.begin(), tile.end(), 0);
+            int rows = std::min(tileSize, ymax - ty * tileSize);
+            int cols = std::min(tileSize, xmax - tx * tileSize);
+            for (int c = 0; c < nColumn; ++c) {
+                const uint32_t* column = static_cast<const uint32_t*>(columns[c]);
+                for (int r = 0; r < rows; ++r) {
+                    const uint32_t* src = column + (size_t) (ty * tileSize + r) * xmax + tx * tileSize;
+                    std::copy(src, src + cols, tile.begin() + c * tileCells + r * tileSize);
+                }
+            }
+            out.write(reinterpret_cast<const char*>(tile.data()), tile.size() * sizeof(uint32_t));
+        }
+    }
+
+    out.close();
+    if (!out || std::rename(tmp.c_str(), filename.c_str()) != 0) {
+        std::remove(tmp.c_str());
+        return false;
+    }
+    return true;
+}
+
+bool TileCache::open(const std::string& filename, uint64_t key, int xmax, int ymax, int nColumn, int maxTiles) {
+    std::ifstream in(filename, std::ios::in | std::ios::binary);
+    if (!in.is_open()) return false;
+    TileHeader header;
+    if (!in.read(reinterpret_cast<char*>(&header), sizeof header) || std::memcmp(header.magic, magic, sizeof magic) != 0
+            || header.version != version || header.byteOrder != byteOrderMark || header.key != key
+            || header.xmax != xmax || header.ymax != ymax || header.tileSize != tileSize || header.nColumn != nColumn) {
+        return false;
+    }
+
+    int tilesX = (xmax + tileSize - 1) / tileSize;
+    int tilesY = (ymax + tileSize - 1) / tileSize;
+    size_t tileWords = (size_t) nColumn * tileCells;
+    in.seekg(0, std::ios::end);
+    if ((uint64_t) in.tellg() != sizeof header + (uint64_t) tilesX * tilesY * tileWords * sizeof(uint32_t)) return false;
+
+    m_filename = filename;
+    m_xmax = xmax;
+    m_ymax = ymax;
+    m_tilesX = tilesX;
+    m_tilesY = tilesY;
+    m_maxTiles = std::max(1, maxTiles);
+    m_tileWords = tileWords;
+    prepare(1);
+    return true;
+}
+
+TileCache::TileCache(const TileCache& other) :
+        m_filename(other.m_filename), m_xmax(other.m_xmax), m_ymax(other.m_ymax), m_tilesX(other.m_tilesX), m_tilesY(other.m_tilesY),
+        m_maxTiles(other.m_maxTiles), m_tileWords(other.m_tileWords) {
+    prepare(1);
+}
+
+void TileCache::prepare(int nThread) {
+    m_caches.clear();
+    for (int t = 0; t < nThread; ++t) {
+        std::unique_ptr<ThreadCache> cache(new ThreadCache());
+        cache->file.open(m_filename, std::ios::in | std::ios::binary);
+        cache->tileSlot.assign(nTile(), -1);
+        m_caches.push_back(std::move(cache));
+    }
+}
+
+int TileCache::load(ThreadCache& cache, int tile) const {
+    ++cache.misses;
+    int slot;
+    if ((int) cache.slotTile.size() < m_maxTiles) {
+        // memory for tiles is taken as needed, up to maxTiles
+        slot = cache.slotTile.size();
+        cache.slotTile.push_back(tile);
+        cache.lastUse.push_back(0);
+        cache.data.resize(cache.data.size() + m_tileWords);
+    } else {
+        slot = std::min_element(cache.lastUse.begin(), cache.lastUse.end()) - cache.lastUse.begin();
+        cache.tileSlot[cache.slotTile[slot]] = -1;
+        cache.slotTile[slot] = tile;
+    }
+    cache.tileSlot[tile] = slot;
+
+    uint32_t* data = cache.data.data() + (size_t) slot * m_tileWords;
+    cache.file.clear();
+    cache.file.seekg(sizeof(TileHeader) + (uint64_t) tile * m_tileWords * sizeof(uint32_t));
+    if (!cache.file.read(reinterpret_cast<char*>(data), m_tileWords * sizeof(uint32_t))) {
+        // the file was checked when it was opened, so this only happens if it is changed
+        // while in use. We may be in a parallel region, so this is only recorded here, 
+        // and reported by whoever checks failedTile() between steps
+        std::fill(data, data + m_tileWords, 0);
+        if (cache.failedTile == -1) cache.failedTile = tile;
+    }
+    return slot;
+}
+
+int TileCache::failedTile() const {
+    for (const auto& cache : m_caches) {
+        if (cache->failedTile != -1) return cache->failedTile;
+    }
+    return -1;
+}
+
+TileCache::Stats TileCache::stats(int thread) const {
+    const ThreadCache& cache = *m_caches[thread];
+    Stats stats;
+    stats.hits = cache.hits;
+    stats.misses = cache.misses;
+    stats.resident = cache.slotTile.size();
+    return stats;
+}
@@ -0,0 +1,95 @@
+#ifndef __TILECACHE__
+#define __TILECACHE__
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <string>
+#include <vector>
+#include "omp.h"
+
+/*
+ * The columns of a Landscape stored in a file as square tiles of cells, of
+ * which only the most recently used are held in memory. Porpoises stay close
+ * together, so a few tiles around them serve nearly all lookups, and landscapes
+ * larger than memory can be simulated.
+ *
+ * Each thread has its own least recently used set of tiles, so lookups never
+ * wait for other threads. Tiles are only read, so the copies held by different
+ * threads never disagree.
+ */
+class TileCache {
+public:
+    static const int tileShift = 8;
+    static const int tileSize = 1 << tileShift; // cells along each side of a tile
+    static const int tileCells = tileSize * tileSize;
+
+    struct Stats {
+        int64_t hits { 0 };
+        int64_t misses { 0 };
+        int resident { 0 }; // tiles held in memory
+    };
+
+    TileCache() = default;
+    // a copy reads the same file, through caches of its own (with zeroed stats, for one thread until prepared)
+    TileCache(const TileCache& other);
+    TileCache& operator=(const TileCache&) = delete;
+
+    // Writes columns of xmax * ymax cells to a tile file. Returns false if the file can't be written.
+    static bool write(const std::string& filename, uint64_t key, int xmax, int ymax, int nColumn, const void* const* columns);
+
+    // Opens a tile file written by write() with the same key and dimensions, keeping up to
+    // maxTiles tiles in memory per thread. Returns false if there is no such file.
+    bool open(const std::string& filename, uint64_t key, int xmax, int ymax, int nColumn, int maxTiles);
+
+    // drops the tiles held in memory, and sets up nThread threads with zeroed stats
+    void prepare(int nThread);
+
+    Stats stats(int thread) const;
+    // a tile that could not be read since prepare(), or -1. Only call while no thread reads tiles.
+    int failedTile() const;
+    const std::string& filename() const { return m_filename; }
+    int nThread() const { return m_caches.size(); }
+    int nTile() const { return m_tilesX * m_tilesY; }
+
+    template<class T> T get(int column, int cell) const {
+        int row = cell / m_xmax;
+        int col = cell - row * m_xmax;
+        int tile = (row >> tileShift) * m_tilesX + (col >> tileShift);
+        ThreadCache& cache = *m_caches[omp_get_thread_num()];
+        int slot = cache.tileSlot[tile];
+        if (slot == -1) {
+            slot = load(cache, tile);
+        } else {
+            ++cache.hits;
+        }
+        cache.lastUse[slot] = ++cache.clock;
+        const uint32_t* tileData = cache.data.data() + (size_t) slot * m_tileWords;
+        T value;
+        std::memcpy(&value, tileData + column * tileCells + ((row & (tileSize - 1)) << tileShift) + (col & (tileSize - 1)), sizeof value);
+        return value;
+    }
+
+private:
+    struct ThreadCache {
+        std::ifstream file;
+        std::vector<uint32_t> data; // tile data, slot after slot
+        std::vector<int> slotTile; // tile in each slot
+        std::vector<uint64_t> lastUse; // of each slot
+        std::vector<int> tileSlot; // slot of each tile, -1 if not in memory
+        uint64_t clock { 0 };
+        int64_t hits { 0 };
+        int64_t misses { 0 };
+        int failedTile { -1 };
+    };
+
+    std::string m_filename;
+    int m_xmax { 0 }, m_ymax { 0 }, m_tilesX { 0 }, m_tilesY { 0 };
+    int m_maxTiles { 0 };
+    size_t m_tileWords { 0 }; // 4-byte values per tile, all columns
+    std::vector<std::unique_ptr<ThreadCache>> m_caches;
+
+    int load(ThreadCache& cache, int tile) const; // reads a tile into a free or the least recently used slot
+};
+
+#endif // __TILECACHE__
@@ -0,0 +1,58 @@
+#ifndef __TRACK__
+#define __TRACK__
+#include <vector>
+#include <algorithm>
+#include "Vector2d.hpp"
+
+/*
+ * The positions a porpoise remembers, with the food it found at each, up to a
+ * fixed capacity. Entry 0 is the most recent position. Positions and food are
+ * kept in separate arrays, oldest first, so that sums over the track are plain
+ * loops over contiguous floats. The arrays have room for twice the capacity: new
+ * positions are appended, and only when the end of the arrays is reached are
+ * the remembered entries moved back to the start.
+ */
+class Track {
+private:
+    std::vector<float> m_x, m_y, m_food;
+    int m_capacity { 1 };
+    int m_begin { 0 }, m_end { 0 }; // entries in use
+
+public:
+    void reserve(int capacity) {
+        m_capacity = std::max(1, capacity);
+        m_x.resize(2 * m_capacity);
+        m_y.resize(2 * m_capacity);
+        m_food.resize(2 * m_capacity);
+    }
+    int size() const { return m_end - m_begin; }
+    bool empty() const { return m_end == m_begin; }
+
+    // k'th most recent entry
+    Vector2df pos(int k) const { return Vector2df(m_x[m_end - 1 - k], m_y[m_end - 1 - k]); }
+    float food(int k) const { return m_food[m_end - 1 - k]; }
+    float& food(int k) { return m_food[m_end - 1 - k]; }
+
+    // the n most recent food values, oldest first
+    const float* foods(int n) const { return m_food.data() + m_end - n; }
+
+    // adds a position (with no food found yet), forgetting the oldest if the track is full
+    void push(Vector2df pos) {
+        if (m_food.empty()) reserve(m_capacity);
+        if (m_end == (int) m_food.size()) {
+            int keep = std::min(size(), m_capacity - 1);
+            std::copy(m_x.begin() + m_end - keep, m_x.begin() + m_end, m_x.begin());
+            std::copy(m_y.begin() + m_end - keep, m_y.begin() + m_end, m_y.begin());
+            std::copy(m_food.begin() + m_end - keep, m_food.begin() + m_end, m_food.begin());
+            m_begin = 0;
+            m_end = keep;
+        }
+        m_x[m_end] = pos.x;
+        m_y[m_end] = pos.y;
+        m_food[m_end] = 0;
+        ++m_end;
+        if (size() > m_capacity) ++m_begin;
+    }
+};
+
+#endif // __TRACK__
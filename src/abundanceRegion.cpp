@@ -1,8 +1,6 @@
 
 #include "abundanceRegion.hpp"
 
-Settings* abundanceRegion::_sim {};
-
 void abundanceRegion::addCell(const int cell) {
     _cells.push_back(cell);
 }
@@ -12,17 +10,12 @@ bool abundanceRegion::empty() {
 int abundanceRegion::randomCell() {
     return *select_randomly(_cells.begin(), _cells.end());
 }
-Vector2df abundanceRegion::randomPoint() {
-    Vector2df pos{_sim->pointFromCell(randomCell())};
+Vector2df abundanceRegion::randomPoint(Settings& sim) {
+    Vector2df pos{sim.pointFromCell(sim.water.cell(randomCell()))};
     pos.x += getRandomFloat(-0.49, 0.49);
     pos.y += getRandomFloat(-0.49, 0.49);
     return pos;
 }
-void abundanceRegion::reset_stats() {
-    _births = 0;
-    _deaths = 0;
-    _bycatch = 0;
-}
 
 int abundanceRegion::id() {
     return _id;
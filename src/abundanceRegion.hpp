@@ -6,24 +6,19 @@
 
 /*
  * The abundance region class is a wrapper around a vector of integers
- * denoting the cell numbers that make up one abundance region. 
+ * denoting the cells that make up one abundance region, as indices of
+ * traversable cells (see Settings::water). 
  */
 class abundanceRegion {
-    static Settings* _sim;
     int _id {-1};
     std::vector<int> _cells;
     friend Settings;
 public:
-    int _births{0};
-    int _deaths{0};
-    int _bycatch{0};
-
     abundanceRegion() {};
     void addCell(const int cell);
     bool empty();
     int randomCell();
-    Vector2df randomPoint();
-    void reset_stats();
+    Vector2df randomPoint(Settings& sim);
     int id();
     void setId(int id);
 };
@@ -11,87 +11,115 @@
 #include "Vector2d.hpp"
 #include "Logger.h"
 #include "execHalfhourTasks.h"
+#include "execDailyTasks.h"
+#include "execMonthlyTasks.h"
 
+// calf is only added to population if it is female, assuming a sex ratio of 1:1
+static void weanOrAbandonCalf(Settings& sim, Porpoise& porp) {
+    if (getRandomFloat(0, 1) < 0.5) {
+        porp.weanCalf();
+        sim.counters.birth(porp.countedRegion);
+    } else {
+        porp.abandonCalf();
+    }
+}
+
+template<class F>
 void execDailyTasks(Settings& sim) {
+    if (sim.abundanceInterval == 1) logAbundance(sim);
 
     // regrow food
     for (const int& patch : sim.Patches) {
-        sim.Grid[patch].Regenerate();
+        sim.Grid[patch].Regenerate(sim.FoodGrowthRate);
     }
+    // density-dependent block values, from the number of porpoises now in each block
+    if (sim.densityDependentBlocks) {
+        for (int b = 0; b < sim.nBlocks; ++b) {
+            sim.Blocks[b].setN(sim.counters.totals().block[b]);
+            sim.Blocks[b].calcValue();
+        }
+    }
+    
     const int& season = sim.time->quarter() - 1;
     const int& yday = sim.time->yday() - 1;
     
     // create new gillnet agents
     int netcount = 0; // number of hauls this day
 
-    for (int block = 0; block < sim.fishery.nBlock(); ++block) {
-        for (int type = 0; type < sim.fishery.nType(); ++type) {
-            int newSets = sim.fishery.sampleNumberOfSets(block, yday, season, type);
-            if (newSets > 0) {
-                for (int netcounter = 0; netcounter < newSets; ++netcounter) {
-                    FishingEffort effort = sim.fishery.sampleEffort(block, yday, season, type);
-                    sim.Gillnets.emplace_back(block, type, effort.soaktime, effort.length, effort.pinger);
+    if (F::fishery) {
+        for (int block = 0; block < sim.fishery.nBlock(); ++block) {
+            for (int type = 0; type < sim.fishery.nType(); ++type) {
+                int newSets = sim.fishery.sampleNumberOfSets(block, yday, season, type);
+                if (newSets > 0) {
+                    for (int netcounter = 0; netcounter < newSets; ++netcounter) {
+                        FishingEffort effort = sim.fishery.sampleEffort(block, yday, season, type);
+                        sim.Gillnets.emplace_back(&sim, block, type, effort.soaktime, effort.length, effort.pinger);
+                    }
+                    netcount += newSets;
                 }
-                netcount += newSets;
             }
         }
     }
 
     sim.logger->gillnet_set(netcount);
-
-    // iterate using indices, because we'll add new porpoises as calves are weaned
-    // since we're adding to the back of the vector, we won't iterate over the newborn calves
-    if (sim.time->step() > 0) {
-        int N = Porpoise::Porpoises.size();
-        #pragma omp parallel for
-        for (int i = 0; i < N; ++i) {
-            auto &porp = Porpoise::Porpoises[i];
-            
-            // increase age by 1 day (1/365)
-            porp->Age += 0.002739726f;
-            
-            // dispersal
-            if (sim.Blocks.size() > 1) {
-                porp->considerDispersing();
-            }
     
-            // mating
-            if (yday == porp->matingDay) {
-                porp->Mate();
-            }
-            
-            // giving birth
-            if (porp->isPregnant && yday == porp->calfBirthday) {
-                porp->giveBirth();
-            }
-            
-            // wean calf (weaningDay is -1 unless porp has a calf, so we can check it like this)
-            if (yday == porp->weaningDay) {
-                // calf is only added to population if it is female, assuming a sex ratio of 1:1
-                if (getRandomFloat(0, 1) < 0.5) {
-                    #pragma omp critical
-                    porp->weanCalf();
-                    
-                    // logging. move this code block elsewhere. perhaps to logger class?
-                    int cell = porp->currentCell;
-                    
-                    if (cell >= 0 && cell < sim.ncell) {
-                        
-                        int abundanceRegion = sim.Grid[cell].abundanceBlock;
-                        
-                        if (abundanceRegion >= 0 && abundanceRegion < sim.abundanceRegions.size()) {
-                            #pragma omp atomic
-                            sim.abundanceRegions[abundanceRegion]._births++;
-                            
-                        }
-                    }
-                    
-                } else {
-                    porp->abandonCalf();
-                }
-            }
-            
+    // life-history events due today
+    const int today = EventCalendar::dayNumber(sim.time->year(), sim.time->yday());
+    sim.calendar.process(today, [&](Porpoise& porp, int event) {
+        switch (event) {
+            case EventCalendar::mating:
+                porp.Mate();
+                porp.setMatingDay(true);
+                break;
+            case EventCalendar::birth:
+                if (porp.isPregnant) porp.giveBirth();
+                break;
+            case EventCalendar::weaning:
+                if (porp.withCalf) weanOrAbandonCalf(sim, porp);
+                break;
         }
-    }
+    });
+    
+    // porpoises reaching max_age today die before they move. Their age is only
+    // incremented in the first pass of the day, hence the dailyAging.
+    std::vector<int>& aged = sim.step.aged;
+    aged.clear();
+    sim.ageOuts.process(today, [&](Porpoise& porp, int) {
+        if (porp.Age + Porpoise::dailyAging >= sim.porpoise.max_age) {
+            aged.push_back(porp.index);
+        } else {
+            porp.scheduleAgeOut(today + 1);
+        }
+    });
+    if (aged.size() > 0) Porpoise::remove(sim, aged);
+    
+    // the remaining porpoise tasks are done in the first half-hour pass of the day (see execDailyPorpoiseTasks)
+}
 
+// daily tasks for a single porpoise. Called from within the first half-hour pass
+// of each day, so that each porpoise is visited once per step, even on new days.
+// Scheduled events are handled by execDailyTasks.
+template<class F>
+void execDailyPorpoiseTasks(Settings&, Porpoise& porp) {
+    // increase age by 1 day (1/365)
+    porp.Age += Porpoise::dailyAging;
+    porp.updateCounters(); // in case porp entered the next age class
+    
+    // dispersal
+    if (F::dispersal) { // more than one block
+        porp.considerDispersing();
+    }
 }
+
+#define INSTANTIATE_DAILY_TASKS(fishery, dispersal, tracking) \
+    template void execDailyTasks<Features<fishery, dispersal, tracking>>(Settings& sim); \
+    template void execDailyPorpoiseTasks<Features<fishery, dispersal, tracking>>(Settings& sim, Porpoise& porp);
+
+INSTANTIATE_DAILY_TASKS(false, false, false)
+INSTANTIATE_DAILY_TASKS(false, false, true)
+INSTANTIATE_DAILY_TASKS(false, true, false)
+INSTANTIATE_DAILY_TASKS(false, true, true)
+INSTANTIATE_DAILY_TASKS(true, false, false)
+INSTANTIATE_DAILY_TASKS(true, false, true)
+INSTANTIATE_DAILY_TASKS(true, true, false)
+INSTANTIATE_DAILY_TASKS(true, true, true)
@@ -17,6 +17,7 @@
 #include "Porpoise.hpp"
 #include "Gillnet.h"
 #include "IO.hpp"
+#include "Features.hpp"
 
 class Porpoise;
 class Config;
@@ -24,6 +25,8 @@ class Logger;
 class Timer;
 class Settings;
 
-void execDailyTasks(Settings& sim);
+// instantiated in execDailyTasks.cpp for every combination of Features
+template<class F> void execDailyTasks(Settings& sim);
+template<class F> void execDailyPorpoiseTasks(Settings& sim, Porpoise& porp);
 
 #endif // __execDailyTasks__
@@ -5,6 +5,8 @@
 
 #include <Rcpp.h>
 #include "execHalfhourTasks.h"
+#include "execDailyTasks.h"
+#include "execMonthlyTasks.h"
 #include "Settings.hpp"
 #include "Porpoise.hpp"
 #include "GridCell.hpp"
@@ -12,74 +14,216 @@
 #include "Vector2d.hpp"
 #include "Logger.h"
 #include "Block.hpp"
+#include "SpatialHash.hpp"
+#include "Scheduler.hpp"
+#include "CRWKernel.hpp"
+#include "Features.hpp"
+#include "RandomStream.hpp"
 
-extern pcg32 rng; // import from misc.cpp
+// Gillnet interaction can be evaluated from either side. Agent-centric: every
+// porpoise checks the gillnets in its current cell. Net-centric: porpoises are
+// hashed by cell, and every gillnet looks up the porpoises in the cells it
+// crosses. Both visit the same porpoise-gillnet pairs; the net-centric pass is
+// cheaper whenever the nets cover fewer cells than there are porpoises.
+static bool useNetCentricEntanglement(Settings& sim, int N) {
+    if (sim.entanglementMode != 0) return sim.entanglementMode == 2;
+    if (sim.Gillnets.empty()) return true; // nothing to check, so skip the per-porpoise checks entirely
+    
+    int netcells = 0;
+    for (const auto& gillnet : sim.Gillnets) {
+        netcells += gillnet.cells().size();
+        if (netcells >= N) return false;
+    }
+    return true;
+}
+
+static void entangleNetCentric(Settings& sim, const std::vector<char>& active, std::vector<char>& entangled) {
+    SpatialHash& porpsByCell = sim.step.porpsByCell; // kept between steps to reuse its storage
+    
+    if (sim.Gillnets.empty()) return;
+    
+    int N = sim.Porpoises.size();
+    porpsByCell.build(N, [&](int i) { 
+        return active[i] ? sim.Porpoises[i]->currentCell : -1; 
+    });
+    
+    for (auto& gillnet : sim.Gillnets) {
+        for (const int& cell : gillnet.cells()) {
+            porpsByCell.query(cell, [&](int i) {
+                if (!entangled[i]) entangled[i] = sim.Porpoises[i]->Entangled(&gillnet);
+            });
+        }
+    }
+}
+
+// After eating, porpoises are processed in batches by movement mode, so that each
+// batch runs one kind of move (see StepState::batches). Returning dispersers move 
+// like directed dispersers.
+enum { foragerBatch = 0, directedBatch = 1, coastalBatch = 2 };
+
+static int batchOf(const Porpoise& porp) {
+    switch (porp.movementMode) {
+        case Porpoise::directedDispersal:
+        case Porpoise::returningDispersal:
+            return directedBatch;
+        case Porpoise::coastalDispersal:
+            return coastalBatch;
+        default:
+            return foragerBatch;
+    }
+}
 
+// Estimated relative cost of a porpoise's move. A CRW step is cheap, unless the
+// porpoise is close enough to land or the map edge for its move to trigger the 
+// search for a path around shallow water.
+static float moveCost(Settings& sim, const Porpoise& porp, float maxMove) {
+    if (porp.currentCell == -1) return 0.0f;
+    int cell = porp.currentCell;
+    return std::min(sim.landscape.distToCoast(cell), sim.landscape.distToEdge(cell)) < maxMove ? 8.0f : 1.0f;
+}
+
+// Estimated relative cost of the rest of a porpoise's turn, which is dominated by
+// the path searches done while dispersing
+static float dispersalCost(const Porpoise& porp) {
+    switch (porp.movementMode) {
+        case Porpoise::directedDispersal:
+        case Porpoise::returningDispersal:
+            return 40.0f;
+        case Porpoise::coastalDispersal:
+            return 20.0f;
+        default:
+            return 1.0f;
+    }
+}
+
+// execHalfhourTasks is called by every thread of the team that runs the time loop
+// (see do_sim). The porpoise loops are divided between the threads, while the
+// bookkeeping in between is done by a single thread. Outside a parallel region,
+// everything is simply executed by the calling thread.
+// Disabled features (see Features.hpp) are compiled out of the porpoise loops.
+template<class F>
 void execHalfhourTasks(Settings& sim) {
+    StepState& step = sim.step;
     
-    // let porpoises do their thing
-    // but randomize the order in which they act
-    int N = Porpoise::Porpoises.size();
-    std::vector<int> casualties; // holds indices of porpoises that died in this step
-    std::vector<int> indices(N);
-    std::iota(indices.begin(), indices.end(), 0); // indices from 0 to total number of porps
-    std::shuffle(indices.begin(), indices.end(), rng); // randomize indices
-    
-    #pragma omp parallel for
-    for (int j = 0; j < N; ++j) {
-        int i = indices[j];
-        auto &porp = Porpoise::Porpoises[i];
+    // first pass: daily tasks (on the first step of a day), then move and check 
+    // for gillnets in the porpoise's cell, unless nets are sparse enough to 
+    // check them from the gillnets' side instead. Porpoises that move are 
+    // collected into batches, which are moved together by the CRW kernel.
+    auto prepare = [&](int i, bool daily) {
+        auto &porp = sim.Porpoises[i];
+        
+        if (daily) {
+            execDailyPorpoiseTasks<F>(sim, *porp);
+        }
         
         if (porp->currentCell == -1) {
             Rprintf("porp %d is off-grid!\n", i);
-            continue;
+            return false;
         }
-        bool entangled = false;
         porp->dispersed = false;
+        return true;
+    };
+    
+    auto moveBatch = [&](CRWBatch& batch, const int* lanes) {
+        // move (correlated random walk + memory)
+        batch.move();
+        for (int l = 0; l < batch.size(); ++l) {
+            step.active[lanes[l]] = 1;
+            if (F::fishery && !step.netCentric) {
+                # pragma omp critical
+                step.entangled[lanes[l]] = batch[l]->Entangled();
+            }
+        }
+        batch.clear();
+    };
+    
+    // runs the first pass for the porpoises order[0] ... order[n-1]
+    auto firstPass = [&](const int* order, int n, bool daily) {
+        CRWBatch batch;
+        int lanes[CRWBatch::width]; // porpoise index of each lane
+        for (int k = 0; k < n; ++k) {
+            if (!prepare(order[k], daily)) continue;
+            lanes[batch.size()] = order[k];
+            batch.add(sim.Porpoises[order[k]].get());
+            if (batch.full()) moveBatch(batch, lanes);
+        }
+        if (batch.size() > 0) moveBatch(batch, lanes);
+    };
+    
+    // let porpoises do their thing
+    // but randomize the order in which they act
+    #pragma omp single
+    {
+        step.N = sim.Porpoises.size();
+        step.casualties.clear();
+        step.indices.resize(step.N);
+        step.active.assign(step.N, 0);
+        step.entangled.assign(step.N, 0);
+        std::iota(step.indices.begin(), step.indices.end(), 0); // indices from 0 to total number of porps
+        std::shuffle(step.indices.begin(), step.indices.end(), threadRng()); // randomize indices
+        step.netCentric = F::fishery ? useNetCentricEntanglement(sim, step.N) : true;
+        step.newDay = sim.time->isNewDay();
+        sim.porpoise.updateSurvivalTable(); // in case the survival parameters were changed
         
-        // porpoise dies from old age
-        if (porp->Age >= Porpoise::max_age) {
-            #pragma omp critical 
-            casualties.push_back(i);
-            continue;
+        float maxMove = pow(10, sim.porpoise.maxLogmov) * 0.25f; // longest possible CRW move, in cells
+        step.firstPassSchedule.partition(step.N, omp_get_num_threads(), [&](int j) {
+            return moveCost(sim, *sim.Porpoises[step.indices[j]], maxMove);
+        });
+    }
+    
+    double loopStart = omp_get_wtime();
+    #pragma omp for schedule(dynamic, 1)
+    for (int c = 0; c < step.firstPassSchedule.size(); ++c) {
+        double chunkStart = omp_get_wtime();
+        int begin = step.firstPassSchedule.begin(c);
+        firstPass(step.indices.data() + begin, step.firstPassSchedule.end(c) - begin, step.newDay);
+        sim.threadStats.addBusy(omp_get_wtime() - chunkStart);
+    }
+    sim.threadStats.addWall(omp_get_wtime() - loopStart);
+    
+    #pragma omp single
+    {
+        if (F::fishery && step.netCentric) {
+            entangleNetCentric(sim, step.active, step.entangled);
         }
-
-        // move (correlated random walk + memory)
-        porp->intrinsicMove();
         
-        // gillnet interaction: if porp is entangled in a gillnet, report and skip to next iteration
-        # pragma omp critical
-        entangled = porp->Entangled();
+        // bycatch and food. This is done by one thread in the shuffled order, since
+        // porpoises compete for food: whoever comes first to a patch eats first.
+        // Survivors are sorted into batches by how they move in the rest of the step.
+        for (int b = 0; b < 3; ++b) step.batches[b].clear();
         
-        if (entangled) {
-            int cell = porp->currentCell;
-            if (cell != -1) {
-                int abundanceRegion = sim.Grid[cell].abundanceBlock;
-                if (abundanceRegion != -1) {
-                    #pragma omp atomic
-                    sim.abundanceRegions[abundanceRegion]._bycatch++;
-                }
+        for (int j = 0; j < step.N; ++j) {
+            int i = step.indices[j];
+            if (!step.active[i]) continue;
+            auto &porp = sim.Porpoises[i];
+            
+            // gillnet interaction: if porp is entangled in a gillnet, report and skip to next porpoise
+            if (F::fishery && step.entangled[i]) {
+                sim.counters.bycatch(porp->countedRegion);
+                if (F::tracking) sim.logger->log(sim.time->step(), porp);
+                //sim.debug(0, "Day %d: porp %d got entangled during step %d moving from (%.02f, %.02f) to (%.02f, %.02f)", time.day(), porp->Id, time.step(), porp->X[1], porp->Y[1], porp->X[0], porp->Y[0]);
+                step.casualties.push_back(i);
+                continue;
             }
-            #pragma omp critical
-            sim.logger->log(sim.time->step(), porp);
-            //Logger::debug(0, "Day %d: porp %d got entangled during step %d moving from (%.02f, %.02f) to (%.02f, %.02f)", time.day(), porp->Id, time.step(), porp->X[1], porp->Y[1], porp->X[0], porp->Y[0]);
-            #pragma omp critical
-            casualties.push_back(i);
-            continue;
-        }
-
-        // consume food in patch
-        #pragma omp critical
-        porp->consumeFood();
             
-        // dispersal
+            // consume food in patch
+            porp->consumeFood();
+            
+            step.batches[F::dispersal ? batchOf(*porp) : foragerBatch].push_back(i);
+        }
         
-        if (porp->movementMode == Porpoise::directedDispersal || porp->movementMode == Porpoise::returningDispersal) {
-            porp->disperseTowardsTarget(); 
-        } else if (porp->movementMode == Porpoise::coastalDispersal) {
-            porp->disperseAlongCoast();
+        int nThread = omp_get_num_threads();
+        for (int b = 0; b < 3; ++b) {
+            step.batchSchedule[b].partition(step.batches[b].size(), nThread, [&](int j) {
+                return dispersalCost(*sim.Porpoises[step.batches[b][j]]);
+            });
         }
-  
+    }
+    
+    // dispersal and energy use, common to all batches
+    auto finishTurn = [&](int i) {
+        auto &porp = sim.Porpoises[i];
+        
         if (porp->dispersed) {
             porp->dispersalStepCounter++;
         } else {
@@ -89,53 +233,101 @@ void execHalfhourTasks(Settings& sim) {
         porp->useEnergy();
         
         if (!porp->checkEnergy()) { // if energy is too low, porp dies.
-            #pragma omp critical
-            sim.logger->log(sim.time->step(), porp);
-            #pragma omp critical 
-            casualties.push_back(i);
-            int cell = porp->currentCell;
-            if (cell != -1) {
-                int abundanceRegion = sim.Grid[cell].abundanceBlock;
-                if (abundanceRegion != -1 && abundanceRegion < sim.abundanceRegions.size()) {
-                    #pragma omp atomic
-                    sim.abundanceRegions[abundanceRegion]._deaths++;
-                }
+            if (F::tracking) {
+                #pragma omp critical
+                sim.logger->log(sim.time->step(), porp);
             }
-            continue;
+            #pragma omp critical 
+            step.casualties.push_back(i);
+            sim.counters.death(porp->countedRegion);
+            return;
         }
-        #pragma omp critical 
-        sim.logger->log(sim.time->step(), porp);
+        if (F::tracking) {
+            #pragma omp critical 
+            sim.logger->log(sim.time->step(), porp);
+        }
+    };
+    
+    // second pass: each batch is processed by its own loop, most expensive first. 
+    // Threads move on to the next batch without waiting (nowait), and only wait
+    // for each other once all batches are done.
+    loopStart = omp_get_wtime();
+    
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (int c = 0; c < step.batchSchedule[directedBatch].size(); ++c) {
+        double chunkStart = omp_get_wtime();
+        for (int j = step.batchSchedule[directedBatch].begin(c); j < step.batchSchedule[directedBatch].end(c); ++j) {
+            int i = step.batches[directedBatch][j];
+            sim.Porpoises[i]->disperseTowardsTarget();
+            finishTurn(i);
+        }
+        sim.threadStats.addBusy(omp_get_wtime() - chunkStart);
+    }
+    
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (int c = 0; c < step.batchSchedule[coastalBatch].size(); ++c) {
+        double chunkStart = omp_get_wtime();
+        for (int j = step.batchSchedule[coastalBatch].begin(c); j < step.batchSchedule[coastalBatch].end(c); ++j) {
+            int i = step.batches[coastalBatch][j];
+            sim.Porpoises[i]->disperseAlongCoast();
+            finishTurn(i);
+        }
+        sim.threadStats.addBusy(omp_get_wtime() - chunkStart);
     }
     
-    // remove dead porpoises
-    if (casualties.size() > 0) {
-        std::sort(casualties.begin(), casualties.end());
-        int counter = 0;
-        for (const int& i : casualties) {
-            Porpoise::Porpoises[i + counter] = std::move(Porpoise::Porpoises.back());
-            Porpoise::Porpoises.pop_back();
-            //Porpoise::Porpoises.erase(Porpoise::Porpoises.begin() + i + counter);
-            --counter;
+    #pragma omp for schedule(dynamic, 1) nowait
+    for (int c = 0; c < step.batchSchedule[foragerBatch].size(); ++c) {
+        double chunkStart = omp_get_wtime();
+        for (int j = step.batchSchedule[foragerBatch].begin(c); j < step.batchSchedule[foragerBatch].end(c); ++j) {
+            finishTurn(step.batches[foragerBatch][j]);
         }
+        sim.threadStats.addBusy(omp_get_wtime() - chunkStart);
     }
     
-    int bycatch = 0;
-    int hauled = 0;
-    
-    // haul (remove) gillnets that have reached their maximum soaktime
-    if (sim.Gillnets.size() > 0) {
-        auto it = sim.Gillnets.begin();
-        while (it != sim.Gillnets.end()) {
-            it->soak30m();
-            if (it->haulable()) {
-                bycatch += it->bycatch(); // tally up number of bycaugh porpoises in net
-                ++hauled;
-                sim.Gillnets.erase(it++);
-            } else {
-                ++it;
+    #pragma omp barrier
+    sim.threadStats.addWall(omp_get_wtime() - loopStart);
+    
+    #pragma omp single
+    {
+        // remove dead porpoises
+        Porpoise::remove(sim, step.casualties);
+    
+        int bycatch = 0;
+        int hauled = 0;
+    
+        // haul (remove) gillnets that have reached their maximum soaktime
+        if (F::fishery && sim.Gillnets.size() > 0) {
+            auto it = sim.Gillnets.begin();
+            while (it != sim.Gillnets.end()) {
+                it->soak30m();
+                if (it->haulable()) {
+                    bycatch += it->bycatch(); // tally up number of bycaugh porpoises in net
+                    ++hauled;
+                    sim.Gillnets.erase(it++);
+                } else {
+                    ++it;
+                }
             }
         }
+        sim.logger->bycatch(bycatch);
+        
+        sim.counters.reduce();
+        if (sim.abundanceInterval == 2) logAbundance(sim);
     }
-    sim.logger->bycatch(bycatch);
+}
+
+template<bool Fishery, bool Dispersal, bool Tracking>
+static StepKernels stepKernels() {
+    typedef Features<Fishery, Dispersal, Tracking> F;
+    return { execHalfhourTasks<F>, execDailyTasks<F> };
+}
 
+StepKernels selectStepKernels(bool fishery, bool dispersal, bool tracking) {
+    static const StepKernels kernels[8] = {
+        stepKernels<false, false, false>(), stepKernels<false, false, true>(),
+        stepKernels<false, true, false>(), stepKernels<false, true, true>(),
+        stepKernels<true, false, false>(), stepKernels<true, false, true>(),
+        stepKernels<true, true, false>(), stepKernels<true, true, true>()
+    };
+    return kernels[fishery * 4 + dispersal * 2 + tracking];
 }
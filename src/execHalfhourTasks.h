@@ -17,6 +17,7 @@
 #include "Porpoise.hpp"
 #include "Gillnet.h"
 #include "IO.hpp"
+#include "Features.hpp"
 
 class Porpoise;
 class Config;
@@ -24,6 +25,6 @@ class Logger;
 class Timer;
 class Settings;
 
-void execHalfhourTasks(Settings& sim);
+template<class F> void execHalfhourTasks(Settings& sim);
 
 #endif // __execHalfhourTasks__
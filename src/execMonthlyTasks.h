@@ -24,5 +24,6 @@ class Logger;
 class Timer;
 
 void execMonthlyTasks(Settings& Config);
+void logAbundance(Settings& sim);
     
 #endif // __execMonthlyTasks__
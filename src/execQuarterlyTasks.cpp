@@ -17,11 +17,11 @@ class GridCell;
 
 void execQuarterlyTasks(Settings& sim) {
 
-    GridCell::setSeason(sim.time->quarter() -1);
+    sim.season = sim.time->quarter() - 1;
     float totfood = 0;
     
     for (const int& patch : sim.Patches) {
-        sim.Grid[patch].updateMax();
+        sim.Grid[patch].updateMax(sim);
         totfood += sim.Grid[patch].currentMax;
     }
     
@@ -29,16 +29,6 @@ void execQuarterlyTasks(Settings& sim) {
     //    block.calcDensity();
     //}
     
-        /*
-    for (auto& block : sim->Blocks) {
-        int blockN = std::count_if(Porpoise::Porpoises.begin(), Porpoise::Porpoises.end(), 
-                                   [sim, block](const auto& porp) { 
-                                       return sim->Grid[porp->currentCell]->Block == block.id();
-                                   });
-        if (blockN == 0) blockN = 1;
-        block.setN(blockN); 
-        block.calcValue();
-    }
-         */
+    // density-dependent block values are recomputed daily (see execDailyTasks)
 
 }
@@ -3,32 +3,37 @@
 #include "pcg_random.hpp"
 #include "Vector2d.hpp"
 #include "misc.hpp"
+#include "RandomStream.hpp"
 
 typedef std::pair<Vector2df, Vector2df> _linestring;
 
-// PCG-random from https://www.pcg-random.org/
-pcg_extras::seed_seq_from<std::random_device> seed_source;
-pcg32 rng(seed_source);
-
+// the per-agent draws come from the calling thread's stream (see RandomStream.hpp)
 int getRandomInt(int min, int max) {
-    return std::uniform_int_distribution<int>{min, max}(rng);
+    return threadRng().integer(min, max);
 }
 
 float getRandomFloat(float min, float max) {
-    return std::uniform_real_distribution<float>{min, max}(rng);
+    return min + (max - min) * threadRng().uniform();
 }
 
 int getRandomDiscrete(std::vector<int> *probs) {
-    std::discrete_distribution<int> dist(probs->begin(), probs->end());
-    return dist(rng);
+    double total = 0;
+    for (const int& p : *probs) total += p;
+    double u = threadRng().uniformOpen() * total;
+    int n = probs->size();
+    for (int i = 0; i < n; ++i) {
+        u -= (*probs)[i];
+        if (u < 0) return i;
+    }
+    return n - 1;
 }
 
 float getRandomNormal(float mean, float sd) {
-    return std::normal_distribution<float>{mean, sd}(rng);
+    return mean + sd * threadRng().normal();
 }
 
 template<typename T> void shuffle(std::vector<T> const &x) {
-    std::shuffle (x.begin(), x.end(), rng);
+    std::shuffle (x.begin(), x.end(), threadRng());
 }
 
 
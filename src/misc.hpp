@@ -8,9 +8,7 @@
 
 typedef std::pair<Vector2df, Vector2df> _linestring;
 
-// PCG-random from https://www.pcg-random.org/
-extern pcg32 rng;
-
+// draws from the calling thread's random stream (see RandomStream.hpp)
 int getRandomInt(int min, int max);
 float getRandomFloat(float min, float max);
 int getRandomDiscrete(std::vector<int> *probs);
@@ -21,8 +19,7 @@ template<typename T> void shuffle(std::vector<T> const &x);
 // https://stackoverflow.com/questions/6942273/how-to-get-a-random-element-from-a-c-container
 template<typename Iter>
 Iter select_randomly(Iter start, Iter end) {
-    std::uniform_int_distribution<> dis(0, std::distance(start, end) - 1);
-    std::advance(start, dis(rng));
+    std::advance(start, getRandomInt(0, std::distance(start, end) - 1));
     return start;
 }
 
@@ -30,8 +27,7 @@ Iter select_randomly(Iter start, Iter end) {
 template<typename T>
 T& sample(std::vector<T>& vec) {
     auto start = vec.begin();
-    std::uniform_int_distribution<> dis(0, std::distance(start, vec.end() - 1));
-    std::advance(start, dis(rng));
+    std::advance(start, getRandomInt(0, std::distance(start, vec.end() - 1)));
     return *start;
 }
 
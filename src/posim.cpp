@@ -7,6 +7,8 @@
 #include <chrono>
 #include <cassert>
 #include <list>
+#include <memory>
+#include <exception>
 
 // for unix-alike machines only
 #if !defined(WIN32) && !defined(__WIN32) && !defined(__WIN32__)
@@ -17,6 +19,7 @@
 // load global configuration first, as other classes depend on it.
 #include "pcg_random.hpp"
 #include "misc.hpp"
+#include "RandomStream.hpp"
 #include "Timer.hpp"
 #include "Logger.h"
 #include "Settings.hpp"
@@ -30,21 +33,42 @@
 #include "execDailyTasks.h"
 #include "execMonthlyTasks.h"
 #include "execQuarterlyTasks.h"
-#include "execYearlyTasks.h"
 #include "omp.h"
 
 typedef std::pair<Vector2df, Vector2df> _linestring;
 
-int DEBUG_LEVEL = 0;
+// cells in the bathymetry overview of landscapes read from tiles
+static const int overviewCells = 1000000;
+
+// The bathymetry of every stride-th cell of every stride-th row, with stride chosen so
+// that there are at most about maxCells of them. Landscapes read from tiles are never
+// read whole in R, so this is what R plots them from (see overview_raster).
+static Rcpp::List bathymetryOverview(const Settings& sim, int maxCells) {
+    int stride = std::max(1, (int) std::ceil(std::sqrt((double) sim.ncell / maxCells)));
+    int ncol = (sim.xmx + stride - 1) / stride;
+    int nrow = (sim.ymx + stride - 1) / stride;
+    Rcpp::NumericVector values(ncol * nrow);
+    for (int r = 0; r < nrow; ++r) {
+        for (int c = 0; c < ncol; ++c) {
+            values[r * ncol + c] = sim.landscape.bathymetry(r * stride * sim.xmx + c * stride);
+        }
+    }
+    sim.checkLandscape();
+    return Rcpp::List::create(Rcpp::Named("stride") = stride, Rcpp::Named("values") = values);
+}
 
 // [[Rcpp::export]]
 Rcpp::RObject do_sim(Rcpp::List& RSim) {
     // for now, assume settings are ok from the R side - no checks on parameters
     // todo: add handler to validate configuration before doing stuff
     Rcpp::List conf = RSim["conf"];
-    DEBUG_LEVEL = Rcpp::as<int>(conf["debug"]);
+    
+    // everything about this run is held by sim. It uses the landscape loaded by 
+    // load_landscape(), which is left as it is for other runs, or reads its own
+    std::unique_ptr<Settings> simPtr(new Settings());
+    Settings& sim = *simPtr;
+    sim.debugLevel = Rcpp::as<int>(conf["debug"]);
     Rcpp::IntegerVector N = conf["N"];
-    Porpoise::resetId();
     int nThread = Rcpp::as<int>(conf["nThread"]);
     int nMaxThread = omp_get_max_threads();
     
@@ -59,20 +83,35 @@ Rcpp::RObject do_sim(Rcpp::List& RSim) {
     int start = Rcpp::as<int>(conf["start"]);
     
     Logger logger(steps, follow, Rcpp::as<int>(conf["maxAge"]));
-    Logger::debug(0, "This is PorpSIM v0.1, using up to %d threads", nThread);
-    Logger::debug(0, "Logger set up with debug = %d", DEBUG_LEVEL);
+    sim.debug(0, "This is PorpSIM v0.1, using up to %d threads", nThread);
+    sim.debug(0, "Logger set up with debug = %d", sim.debugLevel);
     
-    Settings sim{conf};
+    if (RSim.containsElementNamed("landscape") && RSim["landscape"] != R_NilValue) {
+        Rcpp::XPtr<Settings> landscape(RSim["landscape"]);
+        if (!landscape.get()) {
+            // a landscape saved with saveRDS(), or from an earlier session
+            Rcpp::stop("landscape is no longer loaded; call load_landscape() again");
+        }
+        sim.useLandscape(*landscape.get());
+        sim.debug(0, "Using loaded landscape");
+    } else {
+        sim.loadLandscape(conf);
+    }
+    sim.configure(conf);
+    sim.random.seed(nThread);
+    sim.random.bind();
     
     Timer time(start);
     sim.logger = &logger;
     sim.time = &time;
+    sim.threadStats.reset(nThread);
+    sim.counters.reset(sim.abundanceRegions.size(), sim.Blocks.size(), nThread);
     
     int ngillnetcells = 0;
     for (const auto& b : sim.FisheryBlocks) ngillnetcells += b.size();
     
-    Logger::debug(0, "Landscape is %d x %d cells (%d in total, %d traversable, %d usuable for gillnets, %d food patches)", sim.xmx, sim.ymx, sim.ncell, sim.TraversableCells.size(), ngillnetcells, sim.Patches.size());
-    Logger::debug(0, "There are %d traversable blocks, %d abundance region(s) and %d fishery region(s)", sim.Blocks.size(), sim.abundanceRegions.size(), sim.FisheryBlocks.size());
+    sim.debug(0, "Landscape is %d x %d cells (%d in total, %d traversable, %d usuable for gillnets, %d food patches)", sim.xmx, sim.ymx, sim.ncell, sim.water.size(), ngillnetcells, sim.Patches.size());
+    sim.debug(0, "There are %d traversable blocks, %d abundance region(s) and %d fishery region(s)", sim.Blocks.size(), sim.abundanceRegions.size(), sim.FisheryBlocks.size());
     
     float curfood = 0;
     float totalfood = 0;
@@ -81,74 +120,144 @@ Rcpp::RObject do_sim(Rcpp::List& RSim) {
         totalfood += sim.Grid[i].currentMax;
     }
     
-    Logger::debug(0, "maxU = %.02f, starting systemic food = %.02f/%.02f", sim.maxU, curfood, totalfood);
+    sim.debug(0, "maxU = %.02f, starting systemic food = %.02f/%.02f", sim.maxU, curfood, totalfood);
     
-    Porpoise::Porpoises.reserve(sum(N)*10);
+    sim.Porpoises.reserve(sum(N)*10);
     // Create initial population of porpoise agents
     int Unstructured = N.size() == 1;
     
     for (int j = 0; j < N.size(); ++j) {
         int blockN = N[j];
         if (j - Unstructured == -1) {
-            Logger::debug(0, "Created %d porpoises, distributed randomly in landscape", blockN);
+            sim.debug(0, "Created %d porpoises, distributed randomly in landscape", blockN);
         } else {
-            Logger::debug(0, "Created %d porpoises in survey block %d", blockN, j-Unstructured);
+            sim.debug(0, "Created %d porpoises in survey block %d", blockN, j-Unstructured);
         }
         
         for (int i = 0; i < blockN; ++i) {
-            Porpoise::Porpoises.push_back(std::unique_ptr<Porpoise>(new Porpoise(j-Unstructured)));
-            logger.log(0, Porpoise::Porpoises.back());
+            Porpoise::add(sim, std::unique_ptr<Porpoise>(new Porpoise(&sim, j-Unstructured)));
+            logger.log(0, sim.Porpoises.back());
         }
     }
+    sim.counters.reduce();
 
-    Logger::debug(0, "Simulation started on yday %d", time.yday());
+    // pick the step kernels for the features used in this run (see Features.hpp)
+    bool dispersal = sim.Blocks.size() > 1;
+    StepKernels kernels = selectStepKernels(sim.fisheryEnabled, dispersal, logger.following());
+    sim.debug(1, "Step kernels: fishery %d, dispersal %d, tracking %d", sim.fisheryEnabled, dispersal, logger.following());
 
-    // delegate work to procedures according to increases in step/day/month/year counters
-    while (time.step() <= steps) {
+    sim.debug(0, "Simulation started on yday %d", time.yday());
 
-        if (time.isNewDay()) {
+    // delegate work to procedures according to increases in step/day/month/year counters.
+    // A single team of threads runs the whole time loop, rather than entering a new
+    // parallel region for every step. Serial work, and anything calling back into R,
+    // is done by the master thread between barriers.
+    // finished is only written by the master thread between the last barrier of a step
+    // and the first barrier of the next, interrupted only before the first barrier,
+    // so all threads read the same value of both.
+    bool finished = time.step() > steps;
+    bool interrupted = false;
+    std::exception_ptr interrupt; // holds an interrupt from R until we have left the parallel region
+    
+    #pragma omp parallel
+    {
+        sim.random.bind(); // each thread draws from its own stream of this simulation
+        while (!finished) {
             
-            #if !defined(WIN32) && !defined(__WIN32) && !defined(__WIN32__)
-                float pct = time.step(); // cast to float
-                pct = (pct / steps) * 100;
-                REprintf("\rProcessing step %d of %d (%.01f%%)\r", time.step(), steps, pct);
-                R_FlushConsole();
-            #endif
-        
-            if (time.isNewMonth()) {
-                
-                if (time.isNewYear()) execYearlyTasks(sim);
-                if (time.isNewQuarter()) execQuarterlyTasks(sim);
+            #pragma omp master
+            {
+                if (time.isNewDay()) {
+                    
+                    #if !defined(WIN32) && !defined(__WIN32) && !defined(__WIN32__)
+                        float pct = time.step(); // cast to float
+                        pct = (pct / steps) * 100;
+                        REprintf("\rProcessing step %d of %d (%.01f%%)\r", time.step(), steps, pct);
+                        R_FlushConsole();
+                    #endif
                 
-                execMonthlyTasks(sim);
-                Rcpp::checkUserInterrupt(); // allow user to interrupt simulation from R
+                    if (time.isNewMonth()) {
+                        
+                        if (time.isNewQuarter()) execQuarterlyTasks(sim);
+                        
+                        execMonthlyTasks(sim);
+                        
+                        try {
+                            Rcpp::checkUserInterrupt(); // allow user to interrupt simulation from R
+                        } catch (...) {
+                            interrupt = std::current_exception();
+                            interrupted = true;
+                        }
+                    }
+                    kernels.daily(sim);
+                }
             }
-            execDailyTasks(sim);
-        }
-        
-        execHalfhourTasks(sim);
-
-        if (Porpoise::Porpoises.size() == 0) {
-            Logger::debug(0, "Population is extinct!");
-            break;
+            #pragma omp barrier
+            if (interrupted) break;
+            
+            kernels.halfhour(sim); // executed by all threads in the team
+            
+            #pragma omp master
+            {
+                if (sim.landscape.tiles() && sim.landscape.tiles()->failedTile() != -1) {
+                    finished = true; // reported by checkLandscape() once we have left the parallel region
+                } else if (sim.Porpoises.size() == 0) {
+                    sim.debug(0, "Population is extinct!");
+                    finished = true;
+                } else {
+                    time.next(); // goto next iteration
+                    finished = time.step() > steps;
+                }
+            }
+            #pragma omp barrier
         }
-        time.next(); // goto next iteration
+        // the other threads of the team outlive this simulation, so they let go of its
+        // streams here. The calling thread stays bound until sim is destroyed.
+        if (omp_get_thread_num() != 0) sim.random.unbind();
     }
     
+    if (interrupt) {
+        std::rethrow_exception(interrupt);
+    }
+    sim.checkLandscape();
+    
     execMonthlyTasks(sim);
     
     if (time.step() > steps) {
-        Logger::debug(0, "Simulation completed after %d steps", time.step());
+        sim.debug(0, "Simulation completed after %d steps", time.step());
     } else {
-        Logger::debug(0, "Stopped prematurely on simulation day %d (yday %d, step %d), because population is extinct!", time.day(), time.yday(), time.step());
+        sim.debug(0, "Stopped prematurely on simulation day %d (yday %d, step %d), because population is extinct!", time.day(), time.yday(), time.step());
     }
     
-
+    for (int t = 0; t < sim.threadStats.size(); ++t) {
+        double busy = sim.threadStats.busy(t);
+        double idle = sim.threadStats.idle(t);
+        sim.debug(1, "Thread %d: %.02f s busy, %.02f s idle (%.01f%%) in porpoise loops", t, busy, idle, 100 * idle / std::max(busy + idle, 1e-9));
+    }
+    
+    if (const TileCache* tiles = sim.landscape.tiles()) {
+        double hits = 0, misses = 0;
+        for (int t = 0; t < tiles->nThread(); ++t) {
+            TileCache::Stats stats = tiles->stats(t);
+            hits += stats.hits;
+            misses += stats.misses;
+            sim.debug(1, "Thread %d: %.01f%% landscape tile cache hits (%.0f lookups, %d of %d tiles in memory)", t, 
+                          100.0 * stats.hits / std::max(stats.hits + stats.misses, (int64_t) 1), (double) (stats.hits + stats.misses), stats.resident, tiles->nTile());
+        }
+        sim.debug(0, "Landscape tile cache: %.02f%% hits, %.0f tiles read", 100 * hits / std::max(hits + misses, 1.0), misses);
+    }
     
-    sim.Gillnets.clear(); // important that this is called before sim goes out of scope, since gillnet destructors free memory on grid cells
     RSim["result"] = clone(logger.toList());
-    Porpoise::Porpoises.clear();
-    //Porpoise::sim = nullptr;
-    //Block::sim = nullptr;
+    if (sim.landscape.tiles()) RSim["overview"] = bathymetryOverview(sim, overviewCells);
     return RSim;
 }
+
+// Reads a landscape, and optionally fishery data, once for use in many calls to do_sim
+// [[Rcpp::export]]
+SEXP new_landscape(Rcpp::List conf) {
+    omp_set_num_threads(std::min(Rcpp::as<int>(conf["nThread"]), omp_get_max_threads()));
+    Rcpp::XPtr<Settings> landscape(new Settings(), true);
+    landscape->debugLevel = Rcpp::as<int>(conf["debug"]);
+    landscape->loadLandscape(conf);
+    if (landscape->landscape.tiles()) landscape.attr("overview") = bathymetryOverview(*landscape.get(), overviewCells);
+    return landscape;
+}